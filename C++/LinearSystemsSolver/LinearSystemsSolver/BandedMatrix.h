@@ -0,0 +1,143 @@
+// BandedMatrix.h
+// Defines the BandedMatrix<T> type, a square matrix whose nonzero elements lie in a band around the diagonal
+// Element (i, j) is stored only if i - lower_bandwidth <= j <= i + upper_bandwidth, every row stores the band as a contiguous array
+// of lower_bandwidth + upper_bandwidth + 1 elements (positions outside the matrix in the first and last rows are zero padding),
+// so the matrix takes O(n * bandwidth) memory and row operations of banded elimination work on contiguous arrays
+
+#pragma once
+#include<vector>
+#include<iostream>
+#include<algorithm>
+
+#include "Matrix.h"
+#include "thread_pool.h"
+
+template<Numerical T>
+class BandedMatrix {
+public:
+	BandedMatrix() : _size(0), _lower(0), _upper(0) {}
+	BandedMatrix(int size, int lower_bandwidth, int upper_bandwidth);
+
+	// takes the band of a square matrix, the bandwidths are found from its nonzero elements
+	static BandedMatrix<T> from_dense(const Matrix<T>& matrix);
+	Matrix<T> to_dense() const;
+
+	int get_size() const { return _size; }
+	int get_row_count() const { return _size; }
+	int get_column_count() const { return _size; }
+	int get_lower_bandwidth() const { return _lower; }
+	int get_upper_bandwidth() const { return _upper; }
+	bool is_tridiagonal() const { return _lower <= 1 && _upper <= 1; }
+	bool in_band(int i, int j) const { return j - i >= -_lower && j - i <= _upper; }
+
+	// element (i, j), zero outside the band
+	T get_value(int i, int j) const { return in_band(i, j) ? _data[index(i, j)] : T(0); }
+	// writable element (i, j), which has to be in the band
+	T& operator()(int i, int j) {
+		if (!in_band(i, j))
+			throw MatrixException("Error: element is outside the band of the banded matrix");
+		return _data[index(i, j)];
+	}
+	// the stored band of row i, element (i, j) is at position j - i + lower_bandwidth
+	T* band_row(int i) { return _data.data() + static_cast<size_t>(i) * width(); }
+	const T* band_row(int i) const { return _data.data() + static_cast<size_t>(i) * width(); }
+
+	// widens the stored band above the diagonal (the new elements are zero), used by banded LU to make room for the fill-in of pivoting
+	void set_upper_bandwidth(int upper_bandwidth);
+
+	// y = A * x, the operator interface used by iterative solvers
+	void multiply(const T* x, T* y) const;
+
+	void print(std::ostream& stream = std::cout) const;
+
+	// rows multiplied by one thread in parallel products
+	static inline int parallel_rows = 4096;
+
+private:
+	int width() const { return _lower + _upper + 1; }
+	size_t index(int i, int j) const { return static_cast<size_t>(i) * width() + (j - i + _lower); }
+
+	int _size;
+	int _lower;
+	int _upper;
+	std::vector<T> _data;
+};
+
+template<Numerical T>
+BandedMatrix<T>::BandedMatrix(int size, int lower_bandwidth, int upper_bandwidth) : _size(size), _lower(lower_bandwidth), _upper(upper_bandwidth)
+{
+	if (size < 0 || lower_bandwidth < 0 || upper_bandwidth < 0)
+		throw MatrixException("Error: invalid dimensions of banded matrix");
+	_data.assign(static_cast<size_t>(size) * width(), T(0));
+}
+
+template<Numerical T>
+BandedMatrix<T> BandedMatrix<T>::from_dense(const Matrix<T>& matrix)
+{
+	if (!matrix.is_square())
+		throw MatrixException("Error: banded matrix has to be square");
+	int size = matrix.get_row_count();
+	int lower = 0, upper = 0;
+	for (int i = 0; i < size; i++)
+		for (int j = 0; j < size; j++) {
+			T value = matrix[i][j];
+			if (value == 0)
+				continue;
+			lower = std::max(lower, i - j);
+			upper = std::max(upper, j - i);
+		}
+
+	BandedMatrix<T> banded(size, lower, upper);
+	for (int i = 0; i < size; i++)
+		for (int j = std::max(0, i - lower); j <= std::min(size - 1, i + upper); j++)
+			banded(i, j) = matrix[i][j];
+	return banded;
+}
+
+template<Numerical T>
+Matrix<T> BandedMatrix<T>::to_dense() const
+{
+	Matrix<T> dense(_size, _size);
+	for (int i = 0; i < _size; i++)
+		for (int j = std::max(0, i - _lower); j <= std::min(_size - 1, i + _upper); j++)
+			dense[i][j] = _data[index(i, j)];
+	return dense;
+}
+
+template<Numerical T>
+void BandedMatrix<T>::set_upper_bandwidth(int upper_bandwidth)
+{
+	if (upper_bandwidth == _upper)
+		return;
+	BandedMatrix<T> widened(_size, _lower, upper_bandwidth);
+	int copied = std::min(_upper, upper_bandwidth) + _lower + 1;
+	for (int i = 0; i < _size; i++)
+		std::copy(band_row(i), band_row(i) + copied, widened.band_row(i));
+	*this = std::move(widened);
+}
+
+template<Numerical T>
+void BandedMatrix<T>::multiply(const T* x, T* y) const
+{
+	auto multiply_rows = [&](int block) {
+		int last = std::min((block + 1) * parallel_rows, _size);
+		for (int i = block * parallel_rows; i < last; i++) {
+			int first_column = std::max(0, i - _lower);
+			int end_column = std::min(_size, i + _upper + 1);
+			y[i] = VectorKernels<T>::dot(end_column - first_column, band_row(i) + (first_column - i + _lower), x + first_column);
+		}
+	};
+	ThreadPool::instance().parallel_for(0, (_size + parallel_rows - 1) / parallel_rows, multiply_rows);
+}
+
+// prints the matrix in the format of matrix_loader::load_banded
+template<Numerical T>
+void BandedMatrix<T>::print(std::ostream& stream) const
+{
+	stream << _size << " " << _lower << " " << _upper << std::endl;
+	for (int i = 0; i < _size; i++) {
+		for (int j = std::max(0, i - _lower); j <= std::min(_size - 1, i + _upper); j++)
+			stream << _data[index(i, j)] << " ";
+		stream << std::endl;
+	}
+}
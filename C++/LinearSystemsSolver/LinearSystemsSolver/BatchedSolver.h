@@ -0,0 +1,171 @@
+// BatchedSolver.h
+// Solves many small independent systems of the same size at once (meant for sizes of about 3 to 32)
+// The systems are given as one contiguous array of n x n+1 row-major systems (the last column is the right side, as in LinSolver::solve_lu)
+// Groups of `lanes` systems are interleaved: element (i, j) of the k-th system of a group is stored at ((i * (n + 1)) + j) * lanes + k,
+// so the innermost loops of the elimination run over the systems of the group and are vectorized, every SIMD lane solving another system
+// Groups are distributed over the thread pool, every task works in a buffer allocated once for all its groups
+// Failures are reported per system by a status code instead of exceptions, the other systems of the batch are still solved
+
+#pragma once
+#include<vector>
+#include<algorithm>
+
+#include "Matrix.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+enum class BatchStatus : unsigned char {
+	Success = 0,
+	// zero pivot met by the elimination with partial pivoting, the solution of the system is set to zero
+	Singular = 1
+};
+
+template<Numerical T>
+class BatchedSolver {
+public:
+	// systems holds count systems of size x size + 1 elements, solutions receives count vectors of size elements
+	// and statuses count status codes; the arrays must not overlap
+	static void solve(const int size, const int count, const T* systems, T* solutions, BatchStatus* statuses);
+	// same as above, the number of systems is given by the size of the systems vector
+	static std::vector<BatchStatus> solve(const int size, const std::vector<T>& systems, std::vector<T>& solutions);
+
+	// systems of one interleaved group, the row updates are done by VectorKernels<T>::lane_axpy
+	static constexpr int lanes = simd_lanes;
+	// groups solved by one task of the thread pool
+	static inline int groups_per_task = 32;
+
+private:
+	static void load_group(const int size, const int first, const int group_count, const T* systems, T* work);
+	static void eliminate_group(const int size, T* work, BatchStatus* status);
+	static void store_group(const int size, const int first, const int group_count, const T* work, const BatchStatus* status, T* solutions, BatchStatus* statuses);
+};
+
+template<Numerical T>
+void BatchedSolver<T>::solve(const int size, const int count, const T* systems, T* solutions, BatchStatus* statuses)
+{
+	if (size < 1 || count < 0)
+		throw SystemSolverException("Error: cannot solve batch, invalid system size or count");
+	int group_count = (count + lanes - 1) / lanes;
+	int task_count = (group_count + groups_per_task - 1) / groups_per_task;
+	size_t group_elements = static_cast<size_t>(size) * (size + 1) * lanes;
+
+	ThreadPool::instance().parallel_for(0, task_count, [&](int task) {
+		std::vector<T> work(group_elements);
+		BatchStatus status[lanes];
+		int last_group = std::min(group_count, (task + 1) * groups_per_task);
+		for (int group = task * groups_per_task; group < last_group; group++) {
+			int first = group * lanes;
+			int in_group = std::min(lanes, count - first);
+			load_group(size, first, in_group, systems, work.data());
+			eliminate_group(size, work.data(), status);
+			store_group(size, first, in_group, work.data(), status, solutions, statuses);
+		}
+	});
+}
+
+template<Numerical T>
+std::vector<BatchStatus> BatchedSolver<T>::solve(const int size, const std::vector<T>& systems, std::vector<T>& solutions)
+{
+	size_t system_elements = static_cast<size_t>(size) * (size + 1);
+	if (size < 1 || systems.size() % system_elements != 0)
+		throw SystemSolverException("Error: cannot solve batch, the array does not hold whole systems of the given size");
+	int count = static_cast<int>(systems.size() / system_elements);
+	solutions.resize(static_cast<size_t>(count) * size);
+	std::vector<BatchStatus> statuses(count);
+	solve(size, count, systems.data(), solutions.data(), statuses.data());
+	return statuses;
+}
+
+// Interleaves group_count systems starting at system first, the unused lanes of the last group get the system I * x = 0
+template<Numerical T>
+void BatchedSolver<T>::load_group(const int size, const int first, const int group_count, const T* systems, T* work)
+{
+	int width = size + 1;
+	size_t system_elements = static_cast<size_t>(size) * width;
+	// the systems are read as group_count parallel streams, so the buffer is written contiguously
+	const T* group = systems + first * system_elements;
+	for (size_t e = 0; e < system_elements; e++)
+		for (int k = 0; k < group_count; k++)
+			work[e * lanes + k] = group[k * system_elements + e];
+	for (int k = group_count; k < lanes; k++)
+		for (int i = 0; i < size; i++)
+			for (int j = 0; j < width; j++)
+				work[(static_cast<size_t>(i) * width + j) * lanes + k] = i == j ? T(1) : T(0);
+}
+
+// Gaussian elimination with partial pivoting followed by back substitution, the solution replaces the right side column
+// Every lane pivots on its own, so row switches are done lane by lane; the pivot search and the row updates are done for all lanes together
+// A lane with a zero pivot is marked singular and continues with the pivot replaced by one, so no lane ever divides by zero
+template<Numerical T>
+void BatchedSolver<T>::eliminate_group(const int size, T* work, BatchStatus* status)
+{
+	using std::abs;
+	int width = size + 1;
+	auto at = [&](int i, int j) { return work + (static_cast<size_t>(i) * width + j) * lanes; };
+	T pivot[lanes], factor[lanes], largest[lanes];
+	int pivot_row[lanes];
+	for (int l = 0; l < lanes; l++)
+		status[l] = BatchStatus::Success;
+
+	for (int k = 0; k < size; k++) {
+		for (int l = 0; l < lanes; l++) {
+			largest[l] = abs(at(k, k)[l]);
+			pivot_row[l] = k;
+		}
+		for (int i = k + 1; i < size; i++) {
+			const T* column_k = at(i, k);
+			for (int l = 0; l < lanes; l++) {
+				T value = abs(column_k[l]);
+				// selects instead of a branch, the lanes pivot on different rows
+				bool greater = largest[l] < value;
+				largest[l] = greater ? value : largest[l];
+				pivot_row[l] = greater ? i : pivot_row[l];
+			}
+		}
+		for (int l = 0; l < lanes; l++) {
+			if (pivot_row[l] != k)
+				for (int j = k; j < width; j++)
+					std::swap(at(k, j)[l], at(pivot_row[l], j)[l]);
+			pivot[l] = at(k, k)[l];
+			if (pivot[l] == 0) {
+				status[l] = BatchStatus::Singular;
+				pivot[l] = T(1);
+			}
+		}
+
+		// the rest of row k (columns k + 1 ... n, including the right side) is contiguous for all lanes
+		for (int i = k + 1; i < size; i++) {
+			const T* column_k = at(i, k);
+			for (int l = 0; l < lanes; l++)
+				factor[l] = -(column_k[l] / pivot[l]);
+			VectorKernels<T>::lane_axpy(width - k - 1, factor, at(k, k + 1), at(i, k + 1));
+		}
+	}
+
+	for (int i = size - 1; i >= 0; i--) {
+		T* x_i = at(i, size);
+		for (int j = i + 1; j < size; j++) {
+			const T* a_ij = at(i, j);
+			const T* x_j = at(j, size);
+			for (int l = 0; l < lanes; l++)
+				x_i[l] = x_i[l] - a_ij[l] * x_j[l];
+		}
+		const T* a_ii = at(i, i);
+		for (int l = 0; l < lanes; l++) {
+			T diagonal = a_ii[l];
+			x_i[l] = diagonal == 0 ? T(0) : x_i[l] / diagonal;
+		}
+	}
+}
+
+template<Numerical T>
+void BatchedSolver<T>::store_group(const int size, const int first, const int group_count, const T* work, const BatchStatus* status, T* solutions, BatchStatus* statuses)
+{
+	int width = size + 1;
+	for (int k = 0; k < group_count; k++) {
+		T* solution = solutions + static_cast<size_t>(first + k) * size;
+		statuses[first + k] = status[k];
+		for (int i = 0; i < size; i++)
+			solution[i] = status[k] == BatchStatus::Success ? work[(static_cast<size_t>(i) * width + size) * lanes + k] : T(0);
+	}
+}
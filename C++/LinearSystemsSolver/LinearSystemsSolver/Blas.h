@@ -0,0 +1,245 @@
+// Blas.h
+// Level 1, 2 and 3 routines in the style of BLAS, all results are written to views owned by the caller and nothing is allocated,
+// so loops calling them (time stepping, refinement) run without any heap traffic once their buffers exist:
+// axpy: y = alpha * x + y                            dot:  x[0] * y[0] + ... + x[n-1] * y[n-1]
+// gemv: y = alpha * op(A) * x + beta * y             trsv: x = op(A)^-1 * x for a triangular A
+// gemm: C = alpha * op(A) * op(B) + beta * C         trsm: B = alpha * op(A)^-1 * B for a triangular A
+// op(X) is X or X transposed as chosen by the transpose flags, a transpose is never formed, the routines read the elements in the transposed order
+// Matrices are MatrixViews, so any block of a Matrix<T> (get_submatrix) can be an operand; vectors are VectorViews, rows or columns of a matrix included
+// Contiguous vectors use VectorKernels<T> (simd_kernels.h), products are computed by Gemm (gemm.h) and large ones in parallel
+// When beta is 0 the previous content of the output is not read (as in BLAS), outputs must not overlap the inputs except for the in-place solves
+// Only the output view deduces T, the other operands convert to it, so a Matrix<T> view can be passed where a read-only view is expected
+
+#pragma once
+#include<algorithm>
+#include<type_traits>
+
+#include "Matrix.h"
+#include "MatrixView.h"
+#include "gemm.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+
+class Blas {
+public:
+	template<Numerical T>
+	static void axpy(const std::type_identity_t<T> alpha, const VectorView<const std::type_identity_t<T>>& x, const VectorView<T>& y);
+	// x may be a read-only or a writable view, T is deduced from it
+	template<typename T> requires Numerical<std::remove_const_t<T>>
+	static std::remove_const_t<T> dot(const VectorView<T>& x, const VectorView<const std::remove_const_t<T>>& y);
+
+	// op(A) is m x n, x has n and y m elements
+	template<Numerical T>
+	static void gemv(const bool transpose, const std::type_identity_t<T> alpha, const MatrixView<const std::type_identity_t<T>>& a,
+		const VectorView<const std::type_identity_t<T>>& x, const std::type_identity_t<T> beta, const VectorView<T>& y);
+	// A is square, only its lower (or upper) triangle is read, with unit_diagonal the diagonal is taken as ones and not read
+	template<Numerical T>
+	static void trsv(const bool lower, const bool transpose, const bool unit_diagonal, const MatrixView<const std::type_identity_t<T>>& a, const VectorView<T>& x);
+
+	// op(A) is m x k, op(B) k x n and C m x n
+	template<Numerical T>
+	static void gemm(const bool transpose_a, const bool transpose_b, const std::type_identity_t<T> alpha, const MatrixView<const std::type_identity_t<T>>& a,
+		const MatrixView<const std::type_identity_t<T>>& b, const std::type_identity_t<T> beta, const MatrixView<T>& c);
+	// solves op(A) * X = alpha * B for all the columns of B at once, X overwrites B
+	// blocks of block_size rows are solved by substitution, the solved blocks are subtracted from the rest by Gemm
+	template<Numerical T>
+	static void trsm(const bool lower, const bool transpose, const bool unit_diagonal, const std::type_identity_t<T> alpha,
+		const MatrixView<const std::type_identity_t<T>>& a, const MatrixView<T>& b, const int block_size = 64);
+
+	// elements of the output processed by one iteration of a parallel loop of gemv
+	static inline int gemv_block = 1 << 16;
+
+private:
+	// dot and axpy of a contiguous row of a matrix with n elements of a vector with the given stride
+	template<Numerical T>
+	static T row_dot(const int n, const T* row, const T* x, const int stride);
+	template<Numerical T>
+	static void row_axpy(const int n, const T alpha, const T* row, T* y, const int stride);
+};
+
+template<Numerical T>
+void Blas::axpy(const std::type_identity_t<T> alpha, const VectorView<const std::type_identity_t<T>>& x, const VectorView<T>& y)
+{
+	if (x.size() != y.size())
+		throw MatrixException("Error: vectors have different sizes");
+	if (x.stride() == 1)
+		row_axpy<T>(y.size(), alpha, x.data(), y.data(), y.stride());
+	else
+		for (int i = 0; i < y.size(); i++)
+			y[i] = y[i] + alpha * x[i];
+}
+
+template<typename T> requires Numerical<std::remove_const_t<T>>
+std::remove_const_t<T> Blas::dot(const VectorView<T>& x, const VectorView<const std::remove_const_t<T>>& y)
+{
+	using U = std::remove_const_t<T>;
+	if (x.size() != y.size())
+		throw MatrixException("Error: vectors have different sizes");
+	if (x.stride() == 1)
+		return row_dot<U>(x.size(), x.data(), y.data(), y.stride());
+	if (y.stride() == 1)
+		return row_dot<U>(x.size(), y.data(), x.data(), x.stride());
+	U dot = 0;
+	for (int i = 0; i < x.size(); i++)
+		dot = dot + x[i] * y[i];
+	return dot;
+}
+
+// Without transpose every element of y is a dot product of a row of A with x, blocks of rows are computed in parallel
+// With transpose y is a sum of the rows of A scaled by the elements of x, blocks of columns are computed in parallel, so every thread
+// accumulates into its own part of y and every row of A is still read contiguously
+template<Numerical T>
+void Blas::gemv(const bool transpose, const std::type_identity_t<T> alpha, const MatrixView<const std::type_identity_t<T>>& a,
+	const VectorView<const std::type_identity_t<T>>& x, const std::type_identity_t<T> beta, const VectorView<T>& y)
+{
+	const int row_count = a.get_row_count();
+	const int column_count = a.get_column_count();
+	if ((transpose ? row_count : column_count) != x.size() || (transpose ? column_count : row_count) != y.size())
+		throw MatrixException("Error when multiplying matrix and vector: incompatible dimensions.");
+
+	const bool alpha_is_one = alpha == 1;
+	const bool beta_is_zero = beta == 0;
+	ThreadPool& pool = ThreadPool::instance();
+	if (!transpose) {
+		const int rows_per_block = std::max(1, gemv_block / std::max(1, column_count));
+		auto multiply_rows = [&](int block) {
+			int last = std::min((block + 1) * rows_per_block, row_count);
+			for (int i = block * rows_per_block; i < last; i++) {
+				T sum = row_dot<T>(column_count, a[i], x.data(), x.stride());
+				if (!alpha_is_one)
+					sum = alpha * sum;
+				y[i] = beta_is_zero ? sum : sum + beta * y[i];
+			}
+		};
+		pool.parallel_for(0, (row_count + rows_per_block - 1) / rows_per_block, multiply_rows);
+		return;
+	}
+
+	const int columns_per_block = std::max(64, gemv_block / std::max(1, row_count));
+	auto multiply_columns = [&](int block) {
+		int first = block * columns_per_block;
+		int count = std::min(columns_per_block, column_count - first);
+		T* target = y.data() + static_cast<size_t>(first) * y.stride();
+		for (int j = 0; j < count; j++)
+			target[j * y.stride()] = beta_is_zero ? T(0) : beta * target[j * y.stride()];
+		for (int i = 0; i < row_count; i++)
+			row_axpy<T>(count, alpha_is_one ? x[i] : alpha * x[i], a[i] + first, target, y.stride());
+	};
+	pool.parallel_for(0, (column_count + columns_per_block - 1) / columns_per_block, multiply_columns);
+}
+
+// Rows of A are read contiguously in both directions: without transpose x(i) is finished by a dot product of row i with the solved elements,
+// with transpose the solved x(i) is subtracted from the remaining elements with row i as coefficients
+template<Numerical T>
+void Blas::trsv(const bool lower, const bool transpose, const bool unit_diagonal, const MatrixView<const std::type_identity_t<T>>& a, const VectorView<T>& x)
+{
+	const int size = a.get_row_count();
+	if (!a.is_square() || x.size() != size)
+		throw SystemSolverException("Error: cannot solve triangular system, incompatible dimensions");
+
+	const int stride = x.stride();
+	// op(A) is lower triangular, the elements are solved from the first one
+	const bool forward = lower != transpose;
+	for (int step = 0; step < size; step++) {
+		int i = forward ? step : size - 1 - step;
+		const T* row = a[i];
+		if (!unit_diagonal && row[i] == 0)
+			throw SystemSolverException("Error: cannot solve triangular system, zero on the matrixs diagonal");
+		if (!transpose) {
+			int from = lower ? 0 : i + 1;
+			int count = lower ? i : size - i - 1;
+			x[i] = x[i] - row_dot<T>(count, row + from, x.data() + static_cast<size_t>(from) * stride, stride);
+			if (!unit_diagonal)
+				x[i] = x[i] / row[i];
+		}
+		else {
+			if (!unit_diagonal)
+				x[i] = x[i] / row[i];
+			int from = lower ? 0 : i + 1;
+			int count = lower ? i : size - i - 1;
+			row_axpy<T>(count, -x[i], row + from, x.data() + static_cast<size_t>(from) * stride, stride);
+		}
+	}
+}
+
+template<Numerical T>
+void Blas::gemm(const bool transpose_a, const bool transpose_b, const std::type_identity_t<T> alpha, const MatrixView<const std::type_identity_t<T>>& a,
+	const MatrixView<const std::type_identity_t<T>>& b, const std::type_identity_t<T> beta, const MatrixView<T>& c)
+{
+	int m = transpose_a ? a.get_column_count() : a.get_row_count();
+	int k = transpose_a ? a.get_row_count() : a.get_column_count();
+	int n = transpose_b ? b.get_row_count() : b.get_column_count();
+	if ((transpose_b ? b.get_column_count() : b.get_row_count()) != k || c.get_row_count() != m || c.get_column_count() != n)
+		throw MatrixException("Error when multiplying matricies: incompatible dimensions.");
+	Gemm::multiply<T>(a, transpose_a, b, transpose_b, c, alpha, beta);
+}
+
+// Element (i, j) of op(A) is a(j, i) with transpose, op(A) is lower triangular when exactly one of lower and transpose is set
+template<Numerical T>
+void Blas::trsm(const bool lower, const bool transpose, const bool unit_diagonal, const std::type_identity_t<T> alpha,
+	const MatrixView<const std::type_identity_t<T>>& a, const MatrixView<T>& b, const int block_size)
+{
+	int row_count = a.get_row_count();
+	int column_count = b.get_column_count();
+	if (!a.is_square() || b.get_row_count() != row_count)
+		throw SystemSolverException("Error: cannot solve triangular system, incompatible dimensions");
+	if (!(alpha == 1))
+		for (int i = 0; i < row_count; i++)
+			for (int k = 0; k < column_count; k++)
+				b[i][k] = alpha * b[i][k];
+
+	const bool forward = lower != transpose;
+	auto element = [&](int i, int j) { return transpose ? a[j][i] : a[i][j]; };
+	int block = block_size < 1 ? row_count : block_size;
+	for (int done = 0; done < row_count; done += block) {
+		int count = std::min(block, row_count - done);
+		// rows of the current block, going down for lower and up for upper triangles of op(A)
+		int first = forward ? done : row_count - done - count;
+		int end = first + count;
+
+		if (done > 0) {
+			int solved_first = forward ? 0 : end;
+			MatrixView<const T> solved_part = transpose ? a.get_submatrix(solved_first, first, done, count) : a.get_submatrix(first, solved_first, count, done);
+			Gemm::multiply<T>(solved_part, transpose,
+				MatrixView<const T>(b.get_submatrix(solved_first, 0, done, column_count)), false,
+				b.get_submatrix(first, 0, count, column_count), T(-1), T(1));
+		}
+
+		for (int step = 0; step < count; step++) {
+			int i = forward ? first + step : end - 1 - step;
+			int from = forward ? first : i + 1;
+			int to = forward ? i : end;
+			for (int j = from; j < to; j++)
+				VectorKernels<T>::axpy(column_count, -element(i, j), b[j], b[i]);
+			if (!unit_diagonal) {
+				T diagonal = a[i][i];
+				if (diagonal == 0)
+					throw SystemSolverException("Error: cannot solve triangular system, zero on the matrixs diagonal");
+				for (int k = 0; k < column_count; k++)
+					b[i][k] = b[i][k] / diagonal;
+			}
+		}
+	}
+}
+
+template<Numerical T>
+T Blas::row_dot(const int n, const T* row, const T* x, const int stride)
+{
+	if (stride == 1)
+		return VectorKernels<T>::dot(n, row, x);
+	T dot = 0;
+	for (int i = 0; i < n; i++)
+		dot = dot + row[i] * x[static_cast<size_t>(i) * stride];
+	return dot;
+}
+
+template<Numerical T>
+void Blas::row_axpy(const int n, const T alpha, const T* row, T* y, const int stride)
+{
+	if (stride == 1) {
+		VectorKernels<T>::axpy(n, alpha, row, y);
+		return;
+	}
+	for (int i = 0; i < n; i++)
+		y[static_cast<size_t>(i) * stride] = y[static_cast<size_t>(i) * stride] + alpha * row[i];
+}
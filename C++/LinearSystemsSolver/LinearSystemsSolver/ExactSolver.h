@@ -0,0 +1,474 @@
+// ExactSolver.h
+// Exact solvers for systems with integer and Fraction coefficients
+// Fraction arithmetic runs a gcd after every operation and its long numerators silently overflow on larger systems,
+// the solvers here work on plain integers instead and check every operation for overflow (checked_arithmetic.h)
+// solve_bareiss is the fraction-free Gaussian elimination of Bareiss: step k replaces a_ij by (a_kk * a_ij - a_ik * a_kj) / p,
+// where p is the pivot of step k - 1, the division is exact and every entry stays a minor of the matrix, so the number of digits grows
+// only linearly with the size instead of exponentially; the solution is converted to Fractions at the very end
+// A result that does not fit into the integers used is reported by NumberOverflowException,
+// systems of Rationals (rational.h) are eliminated in BigIntegers and cannot overflow
+// solve_multimodular avoids the big numbers during the elimination altogether: the system is solved modulo word size primes
+// (FiniteGroup<p>, one prime per task of the thread pool), the residues are combined by the Chinese remainder theorem
+// and the rational solution is recovered by rational reconstruction; primes are added in batches until the reconstructed
+// solution stays the same for two batches and satisfies the system exactly
+
+#pragma once
+#include<vector>
+#include<concepts>
+#include<algorithm>
+#include<array>
+#include<cstdint>
+#include<utility>
+
+#include "Matrix.h"
+#include "number_types.h"
+#include "rational.h"
+#include "checked_arithmetic.h"
+#include "thread_pool.h"
+
+class ExactSolver {
+public:
+	// solves the system (n x n+1 matrix, the last column is the right side), the elements of the solution are normalized
+	static Matrix<Fraction> solve_bareiss(const Matrix<Fraction>& system);
+	template<std::integral I>
+	static Matrix<Fraction> solve_bareiss(const Matrix<I>& system);
+	static Matrix<Rational> solve_bareiss(const Matrix<Rational>& system);
+
+	// same systems as solve_bareiss, the solutions are the same; the cost grows with the size of the solution, not of the intermediate values
+	static Matrix<Rational> solve_multimodular(const Matrix<Rational>& system);
+	static Matrix<Fraction> solve_multimodular(const Matrix<Fraction>& system);
+	template<std::integral I>
+	static Matrix<Fraction> solve_multimodular(const Matrix<I>& system);
+
+	// the 64 largest primes below 2^62, together they allow solutions of about 1900-bit numerators and denominators;
+	// systems that need more are solved by solve_bareiss
+	static constexpr int prime_count = 64;
+	static constexpr unsigned long long primes[prime_count] = {
+		4611686018427387847ull, 4611686018427387817ull, 4611686018427387787ull, 4611686018427387761ull,
+		4611686018427387751ull, 4611686018427387737ull, 4611686018427387733ull, 4611686018427387709ull,
+		4611686018427387701ull, 4611686018427387631ull, 4611686018427387617ull, 4611686018427387587ull,
+		4611686018427387461ull, 4611686018427387421ull, 4611686018427387409ull, 4611686018427387329ull,
+		4611686018427387323ull, 4611686018427387301ull, 4611686018427387271ull, 4611686018427387241ull,
+		4611686018427387139ull, 4611686018427387131ull, 4611686018427387127ull, 4611686018427387113ull,
+		4611686018427387091ull, 4611686018427387073ull, 4611686018427386981ull, 4611686018427386923ull,
+		4611686018427386911ull, 4611686018427386903ull, 4611686018427386897ull, 4611686018427386887ull,
+		4611686018427386707ull, 4611686018427386663ull, 4611686018427386611ull, 4611686018427386551ull,
+		4611686018427386471ull, 4611686018427386389ull, 4611686018427386351ull, 4611686018427386329ull,
+		4611686018427386323ull, 4611686018427386309ull, 4611686018427386287ull, 4611686018427386231ull,
+		4611686018427386207ull, 4611686018427386203ull, 4611686018427386201ull, 4611686018427386081ull,
+		4611686018427386023ull, 4611686018427385993ull, 4611686018427385981ull, 4611686018427385861ull,
+		4611686018427385831ull, 4611686018427385801ull, 4611686018427385763ull, 4611686018427385717ull,
+		4611686018427385687ull, 4611686018427385657ull, 4611686018427385619ull, 4611686018427385553ull,
+		4611686018427385537ull, 4611686018427385529ull, 4611686018427385507ull, 4611686018427385483ull
+	};
+	// primes dividing the determinant are skipped, a matrix singular modulo more of them is left to solve_bareiss (which detects singular matrices)
+	static inline int max_unlucky_primes = 3;
+
+private:
+	using ModularSolver = bool (*)(const std::vector<BigInteger>& system, const int size, std::vector<uint64_t>& solution);
+
+	// elimination and back substitution on the row-major n x n+1 integer system, the system is overwritten
+	static Matrix<Fraction> bareiss(std::vector<long long>& system, const int size);
+	static Matrix<Rational> bareiss(std::vector<BigInteger>& system, const int size);
+	static void check_system(const int row_count, const int column_count);
+	// rows multiplied by the least common multiple of their denominators
+	static std::vector<BigInteger> to_integer_system(const Matrix<Rational>& system);
+	static Fraction to_fraction(const Rational& value);
+
+	static Matrix<Rational> multimodular(const std::vector<BigInteger>& system, const int size);
+	// Gaussian elimination in FiniteGroup<P>, false if the matrix is singular modulo P
+	template<unsigned long long P>
+	static bool solve_modulo(const std::vector<BigInteger>& system, const int size, std::vector<uint64_t>& solution);
+	static ModularSolver modular_solver(const int prime_index);
+	// combined = the number congruent to combined mod modulus and to residues mod prime, modulus = modulus * prime
+	static void chinese_remainder(std::vector<BigInteger>& combined, BigInteger& modulus, const std::vector<uint64_t>& residues, const unsigned long long prime);
+	// fraction a / b = value mod modulus with |a|, b <= sqrt(modulus / 2), false if there is none
+	static bool reconstruct(const std::vector<BigInteger>& combined, const BigInteger& modulus, Matrix<Rational>& solution);
+	static bool rational_reconstruction(const BigInteger& value, const BigInteger& modulus, const BigInteger& bound, BigInteger& numerator, BigInteger& denominator);
+	static bool is_solution(const std::vector<BigInteger>& system, const int size, const Matrix<Rational>& solution);
+	[[noreturn]] static void overflow() { throw NumberOverflowException("Error: exact solver overflow, the values do not fit into 64-bit integers"); }
+};
+
+// Every row is multiplied by the least common multiple of its denominators, which does not change the solution
+inline Matrix<Fraction> ExactSolver::solve_bareiss(const Matrix<Fraction>& system)
+{
+	int row_count = system.get_row_count(), column_count = system.get_column_count();
+	check_system(row_count, column_count);
+	std::vector<long long> integers(static_cast<size_t>(row_count) * column_count);
+	for (int i = 0; i < row_count; i++) {
+		unsigned long long multiple = 1;
+		for (int j = 0; j < column_count; j++) {
+			Fraction value = system[i][j];
+			value.normalize();
+			unsigned long long denominator = value.get_denominator();
+			unsigned long long factor = denominator / CheckedArithmetic::gcd(multiple, denominator);
+			if (!CheckedArithmetic::multiply(multiple, factor, multiple) || multiple > static_cast<unsigned long long>(std::numeric_limits<long long>::max()))
+				overflow();
+		}
+		for (int j = 0; j < column_count; j++) {
+			Fraction value = system[i][j];
+			value.normalize();
+			long long scale = static_cast<long long>(multiple / value.get_denominator());
+			if (!CheckedArithmetic::multiply(static_cast<long long>(value.get_numerator()), scale, integers[static_cast<size_t>(i) * column_count + j]))
+				overflow();
+		}
+	}
+	return bareiss(integers, row_count);
+}
+
+template<std::integral I>
+Matrix<Fraction> ExactSolver::solve_bareiss(const Matrix<I>& system)
+{
+	int row_count = system.get_row_count(), column_count = system.get_column_count();
+	check_system(row_count, column_count);
+	std::vector<long long> integers(static_cast<size_t>(row_count) * column_count);
+	for (size_t i = 0; i < integers.size(); i++)
+		if (!CheckedArithmetic::narrow(system.data()[i], integers[i]))
+			overflow();
+	return bareiss(integers, row_count);
+}
+
+inline Matrix<Rational> ExactSolver::solve_bareiss(const Matrix<Rational>& system)
+{
+	check_system(system.get_row_count(), system.get_column_count());
+	std::vector<BigInteger> integers = to_integer_system(system);
+	return bareiss(integers, system.get_row_count());
+}
+
+inline Matrix<Rational> ExactSolver::solve_multimodular(const Matrix<Rational>& system)
+{
+	check_system(system.get_row_count(), system.get_column_count());
+	return multimodular(to_integer_system(system), system.get_row_count());
+}
+
+inline Matrix<Fraction> ExactSolver::solve_multimodular(const Matrix<Fraction>& system)
+{
+	Matrix<Rational> solution = solve_multimodular(Matrix<Rational>(system));
+	Matrix<Fraction> result(solution.get_row_count(), 1);
+	for (int i = 0; i < solution.get_row_count(); i++)
+		result(i) = to_fraction(solution(i));
+	return result;
+}
+
+template<std::integral I>
+Matrix<Fraction> ExactSolver::solve_multimodular(const Matrix<I>& system)
+{
+	Matrix<Rational> solution = solve_multimodular(Matrix<Rational>(system));
+	Matrix<Fraction> result(solution.get_row_count(), 1);
+	for (int i = 0; i < solution.get_row_count(); i++)
+		result(i) = to_fraction(solution(i));
+	return result;
+}
+
+inline std::vector<BigInteger> ExactSolver::to_integer_system(const Matrix<Rational>& system)
+{
+	int row_count = system.get_row_count(), column_count = system.get_column_count();
+	std::vector<BigInteger> integers(static_cast<size_t>(row_count) * column_count);
+	for (int i = 0; i < row_count; i++) {
+		BigInteger multiple(1);
+		for (int j = 0; j < column_count; j++) {
+			BigInteger denominator = system[i][j].get_denominator();
+			multiple = multiple / BigInteger::gcd(multiple, denominator) * denominator;
+		}
+		for (int j = 0; j < column_count; j++)
+			integers[static_cast<size_t>(i) * column_count + j] = system[i][j].get_numerator() * (multiple / system[i][j].get_denominator());
+	}
+	return integers;
+}
+
+inline Fraction ExactSolver::to_fraction(const Rational& value)
+{
+	long long numerator, denominator;
+	long small_numerator;
+	unsigned long small_denominator;
+	if (!value.get_numerator().to_long_long(numerator) || !value.get_denominator().to_long_long(denominator)
+		|| !CheckedArithmetic::narrow(numerator, small_numerator) || !CheckedArithmetic::narrow(denominator, small_denominator))
+		overflow();
+	return Fraction(small_numerator, small_denominator);
+}
+
+inline void ExactSolver::check_system(const int row_count, const int column_count)
+{
+	if (column_count != row_count + 1)
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+}
+
+// The rows below the pivot are updated in parallel, every update is one exact division of a 128-bit difference of products
+// With d the last pivot (the determinant up to sign), y = d * x is an integer vector (Cramer's rule), so the back substitution
+// y_i = (d * b_i - sum of a_ij * y_j) / a_ii is fraction-free too and x_i = y_i / d is the only Fraction formed
+inline Matrix<Fraction> ExactSolver::bareiss(std::vector<long long>& system, const int size)
+{
+	const int width = size + 1;
+	auto row = [&](int i) { return system.data() + static_cast<size_t>(i) * width; };
+	long long previous = 1;
+	for (int k = 0; k < size; k++) {
+		// any nonzero pivot keeps the divisions exact
+		int pivot_row = k;
+		while (pivot_row < size && row(pivot_row)[k] == 0)
+			pivot_row++;
+		if (pivot_row == size)
+			throw SystemSolverException("Error: cannot solve system, matrix is singular");
+		if (pivot_row != k)
+			std::swap_ranges(row(k) + k, row(k) + width, row(pivot_row) + k);
+
+		const long long* pivot = row(k);
+		ThreadPool::instance().parallel_for(k + 1, size, [&](int i) {
+			long long* target = row(i);
+			for (int j = k + 1; j < width; j++)
+				if (!CheckedArithmetic::multiply_subtract_divide(pivot[k], target[j], target[k], pivot[j], previous, target[j]))
+					overflow();
+			target[k] = 0;
+		});
+		previous = pivot[k];
+	}
+
+	const long long determinant = previous;
+	std::vector<long long> y(size);
+	Matrix<Fraction> solution(size, 1);
+	for (int i = size - 1; i >= 0; i--) {
+		using WideInt = CheckedArithmetic::WideInt;
+		const long long* current = row(i);
+		WideInt sum = 0, product = 0;
+		if (!CheckedArithmetic::multiply<WideInt>(determinant, current[size], sum))
+			overflow();
+		for (int j = i + 1; j < size; j++)
+			if (!CheckedArithmetic::multiply<WideInt>(current[j], y[j], product) || !CheckedArithmetic::subtract(sum, product, sum))
+				overflow();
+		if (!CheckedArithmetic::narrow(sum / current[i], y[i]))
+			overflow();
+
+		// the sign goes to the numerator, Fraction has an unsigned denominator
+		long long numerator = y[i];
+		if (determinant < 0 && !CheckedArithmetic::subtract(0ll, y[i], numerator))
+			overflow();
+		unsigned long long denominator = determinant < 0 ? 0ull - static_cast<unsigned long long>(determinant) : static_cast<unsigned long long>(determinant);
+		unsigned long long divisor = CheckedArithmetic::gcd(numerator < 0 ? 0ull - static_cast<unsigned long long>(numerator) : static_cast<unsigned long long>(numerator), denominator);
+		long reduced_numerator;
+		unsigned long reduced_denominator;
+		if (!CheckedArithmetic::narrow(numerator / static_cast<long long>(divisor), reduced_numerator)
+			|| !CheckedArithmetic::narrow(denominator / divisor, reduced_denominator))
+			overflow();
+		solution(i) = Fraction(reduced_numerator, reduced_denominator);
+	}
+	return solution;
+}
+
+// Same algorithm in BigIntegers, the entries are minors of the matrix, so their length grows only linearly with the size
+inline Matrix<Rational> ExactSolver::bareiss(std::vector<BigInteger>& system, const int size)
+{
+	const int width = size + 1;
+	auto row = [&](int i) { return system.data() + static_cast<size_t>(i) * width; };
+	BigInteger previous(1);
+	for (int k = 0; k < size; k++) {
+		int pivot_row = k;
+		while (pivot_row < size && row(pivot_row)[k].is_zero())
+			pivot_row++;
+		if (pivot_row == size)
+			throw SystemSolverException("Error: cannot solve system, matrix is singular");
+		if (pivot_row != k)
+			std::swap_ranges(row(k) + k, row(k) + width, row(pivot_row) + k);
+
+		const BigInteger* pivot = row(k);
+		ThreadPool::instance().parallel_for(k + 1, size, [&](int i) {
+			BigInteger* target = row(i);
+			for (int j = k + 1; j < width; j++)
+				target[j] = (pivot[k] * target[j] - target[k] * pivot[j]) / previous;
+			target[k] = BigInteger();
+		});
+		previous = pivot[k];
+	}
+
+	const BigInteger& determinant = previous;
+	std::vector<BigInteger> y(size);
+	Matrix<Rational> solution(size, 1);
+	for (int i = size - 1; i >= 0; i--) {
+		const BigInteger* current = row(i);
+		BigInteger sum = determinant * current[size];
+		for (int j = i + 1; j < size; j++)
+			sum = sum - current[j] * y[j];
+		y[i] = sum / current[i];
+		solution(i) = Rational(y[i], determinant);
+	}
+	return solution;
+}
+
+// Batches of as many primes as there are threads are solved in parallel and combined one by one,
+// after every batch the solution is reconstructed; it is accepted when it did not change since the previous batch
+// and it satisfies the integer system exactly (the check is a product of the matrix and the vector, much cheaper than the elimination)
+inline Matrix<Rational> ExactSolver::multimodular(const std::vector<BigInteger>& system, const int size)
+{
+	const int batch = std::max(2, ThreadPool::instance().get_thread_count());
+	std::vector<std::vector<uint64_t>> residues(batch, std::vector<uint64_t>(size));
+	std::vector<char> solved(batch);
+	std::vector<BigInteger> combined(size);
+	BigInteger modulus(1);
+	Matrix<Rational> previous, solution;
+	bool has_previous = false;
+	int unlucky = 0;
+
+	for (int first = 0; first < prime_count && unlucky <= max_unlucky_primes; first += batch) {
+		int count = std::min(batch, prime_count - first);
+		ThreadPool::instance().parallel_for(0, count, [&](int k) {
+			solved[k] = modular_solver(first + k)(system, size, residues[k]);
+		});
+		for (int k = 0; k < count; k++) {
+			if (solved[k])
+				chinese_remainder(combined, modulus, residues[k], primes[first + k]);
+			else
+				unlucky++;
+		}
+
+		if (modulus == BigInteger(1) || !reconstruct(combined, modulus, solution))
+			continue;
+		bool stable = has_previous;
+		for (int i = 0; stable && i < size; i++)
+			stable = solution(i) == previous(i);
+		if (stable && is_solution(system, size, solution))
+			return solution;
+		previous = std::move(solution);
+		has_previous = true;
+	}
+
+	std::vector<BigInteger> integers = system;
+	return bareiss(integers, size);
+}
+
+template<unsigned long long P>
+bool ExactSolver::solve_modulo(const std::vector<BigInteger>& system, const int size, std::vector<uint64_t>& solution)
+{
+	using F = FiniteGroup<P>;
+	const int width = size + 1;
+	std::vector<F> work(system.size());
+	for (size_t e = 0; e < system.size(); e++)
+		work[e] = F(static_cast<long long>(system[e].remainder(P)));
+	auto row = [&](int i) { return work.data() + static_cast<size_t>(i) * width; };
+
+	for (int k = 0; k < size; k++) {
+		int pivot_row = k;
+		while (pivot_row < size && row(pivot_row)[k] == 0)
+			pivot_row++;
+		// P divides the determinant (or the matrix is singular)
+		if (pivot_row == size)
+			return false;
+		if (pivot_row != k)
+			std::swap_ranges(row(k) + k, row(k) + width, row(pivot_row) + k);
+
+		// the pivot row is scaled to a unit pivot, so the back substitution does not divide
+		F inverse = row(k)[k].inverse();
+		for (int j = k + 1; j < width; j++)
+			row(k)[j] = row(k)[j] * inverse;
+		for (int i = k + 1; i < size; i++)
+			if (!(row(i)[k] == 0))
+				VectorKernels<F>::axpy(width - k - 1, -row(i)[k], row(k) + k + 1, row(i) + k + 1);
+	}
+
+	std::vector<F> x(size);
+	for (int i = size - 1; i >= 0; i--)
+		x[i] = row(i)[size] - VectorKernels<F>::dot(size - i - 1, row(i) + i + 1, x.data() + i + 1);
+	for (int i = 0; i < size; i++)
+		solution[i] = x[i].get_value();
+	return true;
+}
+
+// The moduli of FiniteGroup are template arguments, so solve_modulo is instantiated for every prime of the table
+inline ExactSolver::ModularSolver ExactSolver::modular_solver(const int prime_index)
+{
+	static constexpr auto solvers = []<size_t... I>(std::index_sequence<I...>) {
+		return std::array<ModularSolver, prime_count>{ &solve_modulo<primes[I]>... };
+	}(std::make_index_sequence<prime_count>());
+	return solvers[prime_index];
+}
+
+// Garner's step: x = combined + modulus * t with t = (residue - combined) * modulus^-1 mod prime
+inline void ExactSolver::chinese_remainder(std::vector<BigInteger>& combined, BigInteger& modulus, const std::vector<uint64_t>& residues, const unsigned long long prime)
+{
+	auto multiply_mod = [&](uint64_t a, uint64_t b) { return UInt128::multiply(a, b).remainder(prime); };
+	// modulus^-1 mod prime by Fermat's little theorem
+	uint64_t inverse = 1, base = modulus.remainder(prime);
+	for (unsigned long long exponent = prime - 2; exponent != 0; exponent >>= 1) {
+		if (exponent & 1)
+			inverse = multiply_mod(inverse, base);
+		base = multiply_mod(base, base);
+	}
+
+	ThreadPool::instance().parallel_for(0, static_cast<int>(combined.size()), [&](int i) {
+		uint64_t current = combined[i].remainder(prime);
+		uint64_t difference = residues[i] >= current ? residues[i] - current : residues[i] + prime - current;
+		uint64_t t = multiply_mod(difference, inverse);
+		if (t != 0)
+			combined[i] = combined[i] + modulus * BigInteger(static_cast<long long>(t));
+	});
+	modulus = modulus * BigInteger(static_cast<long long>(prime));
+}
+
+// The components usually share one denominator (the determinant), so every component is first tried with the denominator
+// found so far (one multiplication) and reconstructed by the extended Euclidean algorithm only when that does not give a small numerator
+inline bool ExactSolver::reconstruct(const std::vector<BigInteger>& combined, const BigInteger& modulus, Matrix<Rational>& solution)
+{
+	const int size = static_cast<int>(combined.size());
+	const BigInteger bound = (modulus / BigInteger(2)).sqrt();
+	solution.resize(size, 1);
+	BigInteger denominator(1);
+	for (int i = 0; i < size; i++) {
+		BigInteger numerator = combined[i] * denominator % modulus;
+		// balanced representative in (-modulus / 2, modulus / 2]
+		if (modulus < numerator * BigInteger(2))
+			numerator = numerator - modulus;
+		if (!(bound < abs(numerator))) {
+			solution(i) = Rational(numerator, denominator);
+			continue;
+		}
+		BigInteger component_numerator, component_denominator;
+		if (!rational_reconstruction(combined[i], modulus, bound, component_numerator, component_denominator))
+			return false;
+		solution(i) = Rational(component_numerator, component_denominator);
+		denominator = denominator / BigInteger::gcd(denominator, component_denominator) * component_denominator;
+	}
+	return true;
+}
+
+// Extended Euclidean algorithm on (modulus, value) stopped at the first remainder not above the bound,
+// the remainder is the numerator and the coefficient of value the denominator
+inline bool ExactSolver::rational_reconstruction(const BigInteger& value, const BigInteger& modulus, const BigInteger& bound, BigInteger& numerator, BigInteger& denominator)
+{
+	BigInteger r0 = modulus, r1 = value % modulus, t0(0), t1(1);
+	while (bound < r1) {
+		BigInteger quotient, rest;
+		BigInteger::divide(r0, r1, quotient, rest);
+		r0 = std::move(r1);
+		r1 = std::move(rest);
+		BigInteger t = t0 - quotient * t1;
+		t0 = std::move(t1);
+		t1 = std::move(t);
+	}
+	if (t1.is_zero() || bound < abs(t1) || !(BigInteger::gcd(r1, t1) == BigInteger(1)))
+		return false;
+	numerator = t1.is_negative() ? -r1 : r1;
+	denominator = abs(t1);
+	return true;
+}
+
+// A * (L * x) == L * b in integers, L is the common denominator of the solution
+inline bool ExactSolver::is_solution(const std::vector<BigInteger>& system, const int size, const Matrix<Rational>& solution)
+{
+	const int width = size + 1;
+	BigInteger common(1);
+	for (int i = 0; i < size; i++) {
+		BigInteger denominator = solution(i).get_denominator();
+		common = common / BigInteger::gcd(common, denominator) * denominator;
+	}
+	std::vector<BigInteger> scaled(size);
+	for (int i = 0; i < size; i++)
+		scaled[i] = solution(i).get_numerator() * (common / solution(i).get_denominator());
+
+	std::vector<char> satisfied(size);
+	ThreadPool::instance().parallel_for(0, size, [&](int i) {
+		const BigInteger* row = system.data() + static_cast<size_t>(i) * width;
+		BigInteger sum;
+		for (int j = 0; j < size; j++)
+			if (!row[j].is_zero())
+				sum = sum + row[j] * scaled[j];
+		satisfied[i] = sum == row[size] * common;
+	});
+	return std::all_of(satisfied.begin(), satisfied.end(), [](char value) { return value != 0; });
+}
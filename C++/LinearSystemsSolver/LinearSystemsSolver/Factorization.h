@@ -0,0 +1,187 @@
+// Factorization.h
+// Reusable factorizations: the matrix is factorized once and the factors are then used to solve any number of right sides
+// LUFactorization<T> stores P * A = L * U, QRFactorization<T> stores A = Q * R with Q kept as Householder reflectors
+// CholeskyFactorization<T> and LDLTFactorization<T> store the factors of symmetric matrices
+// Right sides are given either as a std::vector (one vector) or as an n x k Matrix (k right sides, solved together by blocked triangular solves)
+
+#pragma once
+#include<vector>
+
+#include "Matrix.h"
+#include "LinSolver.h"
+
+template<Numerical T>
+class LUFactorization {
+public:
+	LUFactorization() = default;
+	explicit LUFactorization(const Matrix<T>& matrix, const int block_size = 64) { factorize(matrix, block_size); }
+
+	// replaces the stored factors by the factors of the given square matrix
+	void factorize(const Matrix<T>& matrix, const int block_size = 64) {
+		_factors.copy_from(matrix);
+		LinSolver::LU_factorize(_factors, _row_order, block_size);
+		_block_size = block_size;
+	}
+
+	int get_size() const { return _factors.get_row_count(); }
+	// L (below the diagonal, unit diagonal not stored) and U (on and above the diagonal) in a single matrix
+	const Matrix<T>& get_factors() const { return _factors; }
+	// row i of P * A is the row row_order[i] of A
+	const std::vector<int>& get_row_order() const { return _row_order; }
+
+	// solves A * X = B for an n x k matrix of right sides
+	Matrix<T> solve(const Matrix<T>& b) const {
+		Matrix<T> x;
+		solve(b, x);
+		return x;
+	}
+	// same as above, the result is written to x (reusing its buffer when it already has the right size), x may be b itself
+	void solve(const Matrix<T>& b, Matrix<T>& x) const {
+		if (b.get_row_count() != get_size())
+			throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+		if (&x == &b) {
+			// the rows are permuted from a copy, in place the permutation would overwrite rows that were not read yet
+			Matrix<T> original(b);
+			solve(original, x);
+			return;
+		}
+		x.resize(b.get_row_count(), b.get_column_count());
+		for (int i = 0; i < get_size(); i++)
+			x.get_row(i).copy_from(b.get_row(_row_order[i]));
+		LinSolver::solve_triangular<T>(_factors.get_view(), x.get_view(), true, true, _block_size);
+		LinSolver::solve_triangular<T>(_factors.get_view(), x.get_view(), false, false, _block_size);
+	}
+	std::vector<T> solve(const std::vector<T>& b) const {
+		Matrix<T> b_matrix(static_cast<int>(b.size()), 1);
+		std::copy(b.begin(), b.end(), b_matrix.data());
+		return solve(b_matrix).get_column_copy(0);
+	}
+
+private:
+	Matrix<T> _factors;
+	std::vector<int> _row_order;
+	int _block_size = 64;
+};
+
+template<Numerical_WithSqrt T>
+class QRFactorization {
+public:
+	QRFactorization() = default;
+	explicit QRFactorization(const Matrix<T>& matrix) { factorize(matrix); }
+
+	// the reflectors are kept in compact form (see LinSolver::QR_factorize)
+	void factorize(const Matrix<T>& matrix) {
+		_factors.copy_from(matrix);
+		LinSolver::QR_factorize(_factors, _tau);
+	}
+
+	int get_size() const { return _factors.get_row_count(); }
+	const Matrix<T>& get_factors() const { return _factors; }
+	const std::vector<T>& get_tau() const { return _tau; }
+	// Q and R are formed only on request
+	Matrix<T> get_q() const { return LinSolver::QR_form_q(_factors, _tau); }
+	Matrix<T> get_r() const {
+		Matrix<T> r(_factors);
+		for (int i = 1; i < r.get_row_count(); i++)
+			for (int j = 0; j < i; j++)
+				r[i][j] = 0;
+		return r;
+	}
+
+	// solves A * X = B for an n x k matrix of right sides as R * X = Q^H * B (Q^T * B for real types), Q^H is applied by the reflectors
+	Matrix<T> solve(const Matrix<T>& b) const {
+		Matrix<T> x;
+		solve(b, x);
+		return x;
+	}
+	void solve(const Matrix<T>& b, Matrix<T>& x) const {
+		if (b.get_row_count() != get_size())
+			throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+		x.copy_from(b);
+		LinSolver::QR_apply_qt(_factors, _tau, x.get_view());
+		LinSolver::solve_triangular<T>(_factors.get_view(), x.get_view(), false, false);
+	}
+	std::vector<T> solve(const std::vector<T>& b) const {
+		Matrix<T> b_matrix(static_cast<int>(b.size()), 1);
+		std::copy(b.begin(), b.end(), b_matrix.data());
+		return solve(b_matrix).get_column_copy(0);
+	}
+
+private:
+	Matrix<T> _factors;
+	std::vector<T> _tau;
+};
+
+// A = L * L^T for symmetric positive definite matrices, only L is kept
+template<Numerical_WithSqrt T>
+class CholeskyFactorization {
+public:
+	CholeskyFactorization() = default;
+	explicit CholeskyFactorization(const Matrix<T>& matrix, const int block_size = 128) { factorize(matrix, block_size); }
+
+	void factorize(const Matrix<T>& matrix, const int block_size = 128) {
+		_factor.copy_from(matrix);
+		LinSolver::cholesky_factorize(_factor, block_size);
+	}
+
+	int get_size() const { return _factor.get_row_count(); }
+	// L in the lower triangle, zeros above it
+	const Matrix<T>& get_factor() const { return _factor; }
+
+	Matrix<T> solve(const Matrix<T>& b) const {
+		Matrix<T> x;
+		solve(b, x);
+		return x;
+	}
+	void solve(const Matrix<T>& b, Matrix<T>& x) const {
+		x.copy_from(b);
+		LinSolver::cholesky_solve(_factor, x.get_view());
+	}
+	std::vector<T> solve(const std::vector<T>& b) const {
+		Matrix<T> b_matrix(static_cast<int>(b.size()), 1);
+		std::copy(b.begin(), b.end(), b_matrix.data());
+		return solve(b_matrix).get_column_copy(0);
+	}
+
+private:
+	Matrix<T> _factor;
+};
+
+// P * A * P^T = L * D * L^T for symmetric indefinite matrices (see LinSolver::ldlt_factorize for the layout of the factors)
+template<Numerical_WithSqrt T>
+class LDLTFactorization {
+public:
+	LDLTFactorization() = default;
+	explicit LDLTFactorization(const Matrix<T>& matrix) { factorize(matrix); }
+
+	void factorize(const Matrix<T>& matrix) {
+		_factors.copy_from(matrix);
+		LinSolver::ldlt_factorize(_factors, _row_order, _pivot_sizes);
+	}
+
+	int get_size() const { return _factors.get_row_count(); }
+	const Matrix<T>& get_factors() const { return _factors; }
+	const std::vector<int>& get_row_order() const { return _row_order; }
+	// 1 for rows of 1x1 blocks of D, 2 for both rows of a 2x2 block
+	const std::vector<int>& get_pivot_sizes() const { return _pivot_sizes; }
+
+	Matrix<T> solve(const Matrix<T>& b) const {
+		Matrix<T> x;
+		solve(b, x);
+		return x;
+	}
+	void solve(const Matrix<T>& b, Matrix<T>& x) const {
+		x.copy_from(b);
+		LinSolver::ldlt_solve(_factors, _row_order, _pivot_sizes, x.get_view());
+	}
+	std::vector<T> solve(const std::vector<T>& b) const {
+		Matrix<T> b_matrix(static_cast<int>(b.size()), 1);
+		std::copy(b.begin(), b.end(), b_matrix.data());
+		return solve(b_matrix).get_column_copy(0);
+	}
+
+private:
+	Matrix<T> _factors;
+	std::vector<int> _row_order;
+	std::vector<int> _pivot_sizes;
+};
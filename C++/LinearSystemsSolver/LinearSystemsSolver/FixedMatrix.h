@@ -0,0 +1,142 @@
+// FixedMatrix.h
+// Defines the FixedMatrix<T, R, C> type, a matrix with dimensions known at compile time
+// The elements are stored row-major in a std::array, so the matrix lives on the stack and is never allocated on the heap
+// All operations are constexpr, for types with constexpr arithmetic and comparisons (double, FiniteGroup<N>) whole solves can run at compile time
+// LinSolver has overloads of solve_elimination, solve_lu and LU_factorize for fixed matrices, their loops are unrolled by static_for
+// Meant for small systems (2x2 up to about 8x8) solved very many times, larger systems should use Matrix<T>
+
+#pragma once
+#include<array>
+#include<utility>
+#include<type_traits>
+#include<iostream>
+#include<initializer_list>
+
+#include "Matrix.h"
+
+// Calls body(std::integral_constant<int, i>()) for i = Begin ... End - 1
+// The calls are expanded at compile time, inside the body the index is a constant expression (decltype(i)::value)
+template<int Begin, int End, typename Body>
+constexpr void static_for(Body&& body)
+{
+	if constexpr (Begin < End)
+		[&]<int... I>(std::integer_sequence<int, I...>) {
+			(body(std::integral_constant<int, Begin + I>()), ...);
+		}(std::make_integer_sequence<int, End - Begin>());
+}
+
+template<Numerical T, int R, int C>
+class FixedMatrix {
+	static_assert(R > 0 && C > 0, "FixedMatrix dimensions have to be positive");
+public:
+	constexpr FixedMatrix() { _data.fill(T(0)); }
+	// elements in row-major order, the missing elements are zero
+	constexpr FixedMatrix(std::initializer_list<T> values) {
+		if (values.size() > static_cast<size_t>(R * C))
+			throw MatrixException("Error: too many elements for fixed size matrix");
+		_data.fill(T(0));
+		int i = 0;
+		for (auto&& value : values)
+			_data[i++] = value;
+	}
+	explicit FixedMatrix(const Matrix<T>& matrix) {
+		if (matrix.get_row_count() != R || matrix.get_column_count() != C)
+			throw MatrixException("Error: matrix does not have the dimensions of the fixed size matrix");
+		std::copy(matrix.data(), matrix.data() + R * C, _data.begin());
+	}
+
+	static constexpr FixedMatrix<T, R, C> identity() requires (R == C) {
+		FixedMatrix<T, R, C> identity;
+		static_for<0, R>([&](auto i) { identity[i][i] = T(1); });
+		return identity;
+	}
+
+	static constexpr int get_row_count() { return R; }
+	static constexpr int get_column_count() { return C; }
+	static constexpr bool is_square() { return R == C; }
+
+	constexpr T* data() { return _data.data(); }
+	constexpr const T* data() const { return _data.data(); }
+
+	// unchecked row access, matrix[i][j] works as for Matrix<T>
+	constexpr T* operator[](int idx) { return _data.data() + idx * C; }
+	constexpr const T* operator[](int idx) const { return _data.data() + idx * C; }
+	constexpr T& operator()(int i, int j = 0) { return _data[i * C + j]; }
+	constexpr const T& operator()(int i, int j = 0) const { return _data[i * C + j]; }
+
+	MatrixView<T> get_view() { return MatrixView<T>(data(), R, C, C); }
+	MatrixView<const T> get_view() const { return MatrixView<const T>(data(), R, C, C); }
+	Matrix<T> to_matrix() const { return Matrix<T>(get_view()); }
+
+	constexpr FixedMatrix<T, C, R> transpose() const;
+	constexpr FixedMatrix<T, R, C> operator+(const FixedMatrix<T, R, C>& other) const;
+	constexpr FixedMatrix<T, R, C> operator-(const FixedMatrix<T, R, C>& other) const;
+	template<int K>
+	constexpr FixedMatrix<T, R, K> operator*(const FixedMatrix<T, C, K>& other) const;
+	constexpr bool operator==(const FixedMatrix<T, R, C>& other) const;
+
+	void print(std::ostream& stream = std::cout) const;
+
+private:
+	std::array<T, R * C> _data;
+};
+
+template<Numerical T, int R, int C>
+constexpr FixedMatrix<T, C, R> FixedMatrix<T, R, C>::transpose() const
+{
+	FixedMatrix<T, C, R> transposed;
+	static_for<0, R>([&](auto i) {
+		static_for<0, C>([&](auto j) { transposed[j][i] = (*this)[i][j]; });
+	});
+	return transposed;
+}
+
+template<Numerical T, int R, int C>
+constexpr FixedMatrix<T, R, C> FixedMatrix<T, R, C>::operator+(const FixedMatrix<T, R, C>& other) const
+{
+	FixedMatrix<T, R, C> sum;
+	static_for<0, R * C>([&](auto i) { sum._data[i] = _data[i] + other._data[i]; });
+	return sum;
+}
+
+template<Numerical T, int R, int C>
+constexpr FixedMatrix<T, R, C> FixedMatrix<T, R, C>::operator-(const FixedMatrix<T, R, C>& other) const
+{
+	FixedMatrix<T, R, C> difference;
+	static_for<0, R * C>([&](auto i) { difference._data[i] = _data[i] - other._data[i]; });
+	return difference;
+}
+
+template<Numerical T, int R, int C>
+template<int K>
+constexpr FixedMatrix<T, R, K> FixedMatrix<T, R, C>::operator*(const FixedMatrix<T, C, K>& other) const
+{
+	FixedMatrix<T, R, K> product;
+	static_for<0, R>([&](auto i) {
+		static_for<0, K>([&](auto j) {
+			T sum = 0;
+			static_for<0, C>([&](auto k) { sum = sum + (*this)[i][k] * other[k][j]; });
+			product[i][j] = sum;
+		});
+	});
+	return product;
+}
+
+template<Numerical T, int R, int C>
+constexpr bool FixedMatrix<T, R, C>::operator==(const FixedMatrix<T, R, C>& other) const
+{
+	for (int i = 0; i < R * C; i++)
+		if (!(_data[i] == other._data[i]))
+			return false;
+	return true;
+}
+
+template<Numerical T, int R, int C>
+void FixedMatrix<T, R, C>::print(std::ostream& stream) const
+{
+	for (int i = 0; i < R; i++) {
+		for (int j = 0; j < C; j++)
+			stream << (*this)[i][j] << " ";
+		stream << std::endl;
+	}
+}
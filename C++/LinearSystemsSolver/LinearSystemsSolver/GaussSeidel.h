@@ -0,0 +1,321 @@
+// GaussSeidel.h
+// Reusable Gauss-Seidel / SOR / SSOR iteration on a sparse matrix, meant both as a solver and as a smoother applied a fixed number of steps
+// With the multicolor ordering the rows are colored so that no two rows of the same color are coupled by the matrix,
+// rows of one color then depend only on rows of the other colors and are updated in parallel (red-black ordering for 5-point stencils)
+// The coloring, the diagonal and all buffers are computed once in the constructor, steps do not allocate memory
+
+#pragma once
+#include<vector>
+#include<algorithm>
+#include<numeric>
+#include<cmath>
+#include<limits>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+#include "thread_pool.h"
+#include "IterativeSolver.h"
+
+enum class GaussSeidelOrdering { Natural, Multicolor };
+
+template<Numerical T>
+struct GaussSeidelOptions {
+	GaussSeidelOrdering ordering = GaussSeidelOrdering::Multicolor;
+	// relaxation factor omega, 1 is plain Gauss-Seidel, values in (1, 2) give over-relaxation (SOR)
+	T relaxation = T(1);
+	// every step is a forward sweep followed by a backward sweep (SSOR)
+	bool symmetric = false;
+	int max_steps = 10000;
+	// solve stops when every element of the residual b - A * x is within accuracy, checked every check_interval steps
+	// with accuracy 0 it stops at the fixed point instead, when a step no longer changes x (a fixed point stops it with any accuracy);
+	// for floating point and complex types a step moving x by no more than rounding, epsilon * sqrt(size) * the largest element of x, is a fixed point too
+	T accuracy = T(0);
+	int check_interval = 8;
+};
+
+template<Numerical T>
+struct GaussSeidelReport {
+	int steps = 0;
+	bool converged = false;
+	// largest absolute value of an element of the residual at the last check
+	T residual = T(0);
+};
+
+template<Numerical T>
+class GaussSeidel {
+public:
+	explicit GaussSeidel(const SparseMatrix<T>& matrix, const GaussSeidelOptions<T>& options = {});
+	explicit GaussSeidel(const Matrix<T>& matrix, const GaussSeidelOptions<T>& options = {}) : GaussSeidel(SparseMatrix<T>::from_dense(matrix), options) {}
+
+	int get_size() const { return _matrix.get_row_count(); }
+	int get_color_count() const { return static_cast<int>(_color_starts.size()) - 1; }
+	const GaussSeidelOptions<T>& get_options() const { return _options; }
+	// the ordering is fixed by the constructor, the ordering in the new options is ignored
+	void set_options(const GaussSeidelOptions<T>& options);
+
+	// one step (one sweep, or two for SSOR) updating x in place, returns false at a fixed point (see GaussSeidelOptions::accuracy)
+	bool step(const T* b, T* x);
+	// fixed number of steps without convergence checks, the use as a smoother
+	void smooth(const T* b, T* x, const int steps);
+	// iterates until the residual is within accuracy or max_steps is reached, x holds the initial guess
+	GaussSeidelReport<T> solve(const T* b, T* x);
+	// same as above for n x 1 matrices, an x of another size is replaced by a zero vector
+	GaussSeidelReport<T> solve(const Matrix<T>& b, Matrix<T>& x);
+
+	// largest absolute value of an element of b - A * x
+	T residual_norm(const T* b, const T* x);
+
+	// rows of one color updated by one thread
+	static inline int parallel_rows = 1024;
+
+private:
+	void color_rows();
+	void sweep_color(const int color, const T* b, T* x, const bool backward, T& largest_change, T& largest_value);
+	void relax_row(const int row, const T* b, T* x, T& largest_change, T& largest_value) const;
+
+	SparseMatrix<T> _matrix;
+	GaussSeidelOptions<T> _options;
+	bool _relaxed;
+	// relative change of x a step has to exceed not to be a fixed point, 0 for exact types
+	T _rounding = T(0);
+	std::vector<T> _diagonal;
+	// rows of color c are _ordered_rows[_color_starts[c]] ... _ordered_rows[_color_starts[c + 1] - 1]
+	std::vector<int> _color_starts;
+	std::vector<int> _ordered_rows;
+	std::vector<T> _block_residuals;
+	std::vector<T> _block_changes;
+	std::vector<T> _block_values;
+};
+
+template<Numerical T>
+GaussSeidel<T>::GaussSeidel(const SparseMatrix<T>& matrix, const GaussSeidelOptions<T>& options) : _matrix(matrix)
+{
+	if (!_matrix.is_square())
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+	int size = get_size();
+	_diagonal.resize(size);
+	for (int i = 0; i < size; i++) {
+		_diagonal[i] = _matrix.get_value(i, i);
+		if (_diagonal[i] == 0)
+			throw SystemSolverException("Error: cannot compute Gauss Seidel algorithm, zero on the input matrixs diagonal");
+	}
+	_options.ordering = options.ordering;
+	set_options(options);
+	if (_options.ordering == GaussSeidelOrdering::Multicolor)
+		color_rows();
+	else {
+		_color_starts = { 0, size };
+		_ordered_rows.resize(size);
+		std::iota(_ordered_rows.begin(), _ordered_rows.end(), 0);
+	}
+	_block_residuals.resize((size + parallel_rows - 1) / parallel_rows);
+	_block_changes.resize(_block_residuals.size());
+	_block_values.resize(_block_residuals.size());
+	if constexpr (Numerical_Inexact<T>) {
+		using Real = decltype(abs(T(0)));
+		_rounding = T(std::numeric_limits<Real>::epsilon() * std::sqrt(static_cast<Real>(size)));
+	}
+}
+
+template<Numerical T>
+void GaussSeidel<T>::set_options(const GaussSeidelOptions<T>& options)
+{
+	GaussSeidelOrdering ordering = _options.ordering;
+	_options = options;
+	_options.ordering = ordering;
+	T relaxation = _options.relaxation;
+	_relaxed = !(relaxation == 1);
+}
+
+// Greedy coloring of the graph of the matrix (rows i and j are adjacent when a_ij or a_ji is nonzero),
+// every row gets the smallest color not used by its already colored neighbours
+template<Numerical T>
+void GaussSeidel<T>::color_rows()
+{
+	int size = get_size();
+	const std::vector<int>& row_starts = _matrix.get_row_starts();
+	const std::vector<int>& columns = _matrix.get_column_indices();
+
+	// pattern of the transposed matrix, so the neighbours through a_ji are found too
+	std::vector<int> transposed_starts(size + 1, 0);
+	for (int column : columns)
+		transposed_starts[column + 1]++;
+	std::partial_sum(transposed_starts.begin(), transposed_starts.end(), transposed_starts.begin());
+	std::vector<int> transposed_rows(columns.size());
+	std::vector<int> next(transposed_starts.begin(), transposed_starts.end() - 1);
+	for (int i = 0; i < size; i++)
+		for (int k = row_starts[i]; k < row_starts[i + 1]; k++)
+			transposed_rows[next[columns[k]]++] = i;
+
+	std::vector<int> color(size, -1);
+	// used_by[c] == i marks color c as taken by a neighbour of row i
+	std::vector<int> used_by(size + 1, -1);
+	int color_count = 0;
+	for (int i = 0; i < size; i++) {
+		for (int k = row_starts[i]; k < row_starts[i + 1]; k++)
+			if (color[columns[k]] >= 0)
+				used_by[color[columns[k]]] = i;
+		for (int k = transposed_starts[i]; k < transposed_starts[i + 1]; k++)
+			if (color[transposed_rows[k]] >= 0)
+				used_by[color[transposed_rows[k]]] = i;
+		int c = 0;
+		while (used_by[c] == i)
+			c++;
+		color[i] = c;
+		color_count = std::max(color_count, c + 1);
+	}
+
+	_color_starts.assign(color_count + 1, 0);
+	for (int i = 0; i < size; i++)
+		_color_starts[color[i] + 1]++;
+	std::partial_sum(_color_starts.begin(), _color_starts.end(), _color_starts.begin());
+	_ordered_rows.resize(size);
+	next.assign(_color_starts.begin(), _color_starts.end() - 1);
+	for (int i = 0; i < size; i++)
+		_ordered_rows[next[color[i]]++] = i;
+}
+
+// Updates x[row] and raises largest_change to the size of its change, largest_value is only kept for inexact types
+template<Numerical T>
+void GaussSeidel<T>::relax_row(const int row, const T* b, T* x, T& largest_change, T& largest_value) const
+{
+	const std::vector<int>& row_starts = _matrix.get_row_starts();
+	const std::vector<int>& columns = _matrix.get_column_indices();
+	const std::vector<T>& values = _matrix.get_values();
+	T sum = 0;
+	for (int k = row_starts[row]; k < row_starts[row + 1]; k++)
+		if (columns[k] != row)
+			sum = sum + values[k] * x[columns[k]];
+	T updated = (b[row] - sum) / _diagonal[row];
+	const T next = _relaxed ? x[row] + _options.relaxation * (updated - x[row]) : updated;
+	T change = abs(next - x[row]);
+	if (largest_change < change)
+		largest_change = change;
+	if constexpr (Numerical_Inexact<T>) {
+		T value = abs(next);
+		if (largest_value < value)
+			largest_value = value;
+	}
+	x[row] = next;
+}
+
+// Rows of a multicolor color are independent and split into blocks updated in parallel,
+// the single color of the natural ordering is swept sequentially
+template<Numerical T>
+void GaussSeidel<T>::sweep_color(const int color, const T* b, T* x, const bool backward, T& largest_change, T& largest_value)
+{
+	int first = _color_starts[color];
+	int last = _color_starts[color + 1];
+	if (_options.ordering == GaussSeidelOrdering::Natural) {
+		if (backward)
+			for (int k = last - 1; k >= first; k--)
+				relax_row(_ordered_rows[k], b, x, largest_change, largest_value);
+		else
+			for (int k = first; k < last; k++)
+				relax_row(_ordered_rows[k], b, x, largest_change, largest_value);
+		return;
+	}
+	int block_count = (last - first + parallel_rows - 1) / parallel_rows;
+	auto relax_block = [&](int block) {
+		T block_change = 0, block_value = 0;
+		int end = std::min(first + (block + 1) * parallel_rows, last);
+		for (int k = first + block * parallel_rows; k < end; k++)
+			relax_row(_ordered_rows[k], b, x, block_change, block_value);
+		_block_changes[block] = block_change;
+		_block_values[block] = block_value;
+	};
+	ThreadPool::instance().parallel_for(0, block_count, relax_block);
+	for (int block = 0; block < block_count; block++) {
+		if (largest_change < _block_changes[block])
+			largest_change = _block_changes[block];
+		if (largest_value < _block_values[block])
+			largest_value = _block_values[block];
+	}
+}
+
+template<Numerical T>
+bool GaussSeidel<T>::step(const T* b, T* x)
+{
+	T largest_change = 0, largest_value = 0;
+	int color_count = get_color_count();
+	for (int color = 0; color < color_count; color++)
+		sweep_color(color, b, x, false, largest_change, largest_value);
+	if (_options.symmetric)
+		for (int color = color_count - 1; color >= 0; color--)
+			sweep_color(color, b, x, true, largest_change, largest_value);
+	return _rounding * largest_value < largest_change;
+}
+
+template<Numerical T>
+void GaussSeidel<T>::smooth(const T* b, T* x, const int steps)
+{
+	for (int i = 0; i < steps; i++)
+		step(b, x);
+}
+
+template<Numerical T>
+T GaussSeidel<T>::residual_norm(const T* b, const T* x)
+{
+	const std::vector<int>& row_starts = _matrix.get_row_starts();
+	const std::vector<int>& columns = _matrix.get_column_indices();
+	const std::vector<T>& values = _matrix.get_values();
+	int size = get_size();
+	auto block_residual = [&](int block) {
+		T largest = 0;
+		int end = std::min((block + 1) * parallel_rows, size);
+		for (int i = block * parallel_rows; i < end; i++) {
+			T sum = 0;
+			for (int k = row_starts[i]; k < row_starts[i + 1]; k++)
+				sum = sum + values[k] * x[columns[k]];
+			T difference = abs(b[i] - sum);
+			if (largest < difference)
+				largest = difference;
+		}
+		_block_residuals[block] = largest;
+	};
+	ThreadPool::instance().parallel_for(0, static_cast<int>(_block_residuals.size()), block_residual);
+
+	T largest = 0;
+	for (auto&& residual : _block_residuals)
+		if (largest < residual)
+			largest = residual;
+	return largest;
+}
+
+template<Numerical T>
+GaussSeidelReport<T> GaussSeidel<T>::solve(const T* b, T* x)
+{
+	GaussSeidelReport<T> report;
+	const int interval = std::max(1, _options.check_interval);
+	const bool check_residual = T(0) < _options.accuracy;
+	while (report.steps < _options.max_steps) {
+		bool changed = step(b, x);
+		report.steps++;
+		if (!changed) {
+			// fixed point, further steps would not change x beyond rounding
+			report.residual = residual_norm(b, x);
+			report.converged = !check_residual || !(_options.accuracy < report.residual);
+			break;
+		}
+		if ((check_residual && report.steps % interval == 0) || report.steps == _options.max_steps) {
+			report.residual = residual_norm(b, x);
+			if (check_residual && !(_options.accuracy < report.residual)) {
+				report.converged = true;
+				break;
+			}
+		}
+	}
+	return report;
+}
+
+template<Numerical T>
+GaussSeidelReport<T> GaussSeidel<T>::solve(const Matrix<T>& b, Matrix<T>& x)
+{
+	if (b.get_row_count() != get_size() || b.get_column_count() != 1)
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect dimensions");
+	if (x.get_row_count() != get_size() || x.get_column_count() != 1) {
+		x.resize(get_size(), 1);
+		std::fill(x.data(), x.data() + get_size(), T(0));
+	}
+	return solve(b.data(), x.data());
+}
@@ -0,0 +1,440 @@
+// IterativeSolver.h
+// Krylov subspace solvers: conjugate gradients (CG), BiCGSTAB and restarted GMRES
+// The solvers only need matrix-vector products, so they work with any LinearOperator - both Matrix<T> and SparseMatrix<T> are operators
+// All vectors used by a solver live in a KrylovWorkspace<T>, which is sized once and then reused, iterations do not allocate memory
+// Every solve returns an IterativeReport with the iteration count, the residual norm after every iteration and the wall time
+// Every solver optionally takes a preconditioner (Preconditioner.h); BiCGSTAB and GMRES are preconditioned from the right,
+// so the reported residuals are always residuals of the original system
+
+#pragma once
+#include<vector>
+#include<complex>
+#include<cmath>
+#include<chrono>
+#include<concepts>
+#include<type_traits>
+
+#include "Matrix.h"
+#include "simd_kernels.h"
+#include "Preconditioner.h"
+
+// LinearOperator concept
+// A square operator that can compute y = A * x for arrays of get_row_count() elements
+template<typename Operator, typename T>
+concept LinearOperator = requires(const Operator& a, const T* x, T* y) {
+	{ a.get_row_count() } -> std::convertible_to<int>;
+	a.multiply(x, y);
+};
+
+template<typename T>
+struct is_floating_complex : std::false_type {};
+template<std::floating_point F>
+struct is_floating_complex<std::complex<F>> : std::true_type {};
+
+// Numerical_Inexact concept
+// Types Krylov methods make sense for: floating point numbers and complex numbers built from them (double, float, complex<double>)
+// Fraction also converts to double and so has sqrt, but its arithmetic is exact and it is not accepted
+template<typename T>
+concept Numerical_Inexact = Numerical_WithSqrt<T> && std::constructible_from<T, double> && (std::floating_point<T> || is_floating_complex<T>::value);
+
+struct IterativeOptions {
+	int max_iterations = 1000;
+	// the solve stops when ||b - A * x|| <= tolerance * ||b||
+	double tolerance = 1e-10;
+	// number of GMRES iterations between restarts (size of the Krylov basis)
+	int restart = 30;
+	bool record_history = true;
+};
+
+struct IterativeReport {
+	bool converged = false;
+	int iterations = 0;
+	// residual norm of the initial guess followed by the residual norm after every iteration
+	std::vector<double> residual_history;
+	double final_residual = 0;
+	double wall_time_seconds = 0;
+};
+
+// Vectors used by the solvers, kept between solves so repeated solves of the same size allocate nothing
+template<Numerical T>
+class KrylovWorkspace {
+public:
+	void prepare(int size, int vector_count) {
+		if (_size != size || static_cast<int>(_vectors.size()) < vector_count) {
+			_size = size;
+			_vectors.resize(std::max(vector_count, static_cast<int>(_vectors.size())));
+			for (auto&& v : _vectors)
+				v.assign(size, T(0));
+		}
+	}
+	// GMRES also needs the Hessenberg matrix, the Givens rotations and the reduced right side
+	void prepare_gmres(int size, int restart) {
+		prepare(size, restart + 3);
+		if (_hessenberg.get_row_count() != restart + 1 || _hessenberg.get_column_count() != restart) {
+			_hessenberg.resize(restart + 1, restart);
+			_cosines.assign(restart, T(0));
+			_sines.assign(restart, T(0));
+			_reduced.assign(restart + 1, T(0));
+		}
+	}
+	T* vector(int i) { return _vectors[i].data(); }
+
+private:
+	friend class IterativeSolver;
+
+	int _size = -1;
+	std::vector<std::vector<T>> _vectors;
+	Matrix<T> _hessenberg;
+	std::vector<T> _cosines;
+	std::vector<T> _sines;
+	std::vector<T> _reduced;
+};
+
+class IterativeSolver {
+public:
+	// Conjugate gradients, for symmetric (hermitian) positive definite operators and preconditioners
+	// x holds the initial guess and is overwritten by the solution (an empty x starts from zero)
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_cg(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace);
+	// BiCGSTAB, for general nonsymmetric operators
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_bicgstab(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace);
+	// GMRES restarted after options.restart iterations, for general operators, the residual norm never increases
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_gmres(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace);
+
+	// same as above with a temporary workspace
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_cg(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_cg(a, b, x, preconditioner, options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_bicgstab(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_bicgstab(a, b, x, preconditioner, options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+	static IterativeReport solve_gmres(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_gmres(a, b, x, preconditioner, options, workspace);
+	}
+
+	// without preconditioning
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_cg(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options, KrylovWorkspace<T>& workspace) {
+		return solve_cg(a, b, x, IdentityPreconditioner<T>(a.get_row_count()), options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_bicgstab(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options, KrylovWorkspace<T>& workspace) {
+		return solve_bicgstab(a, b, x, IdentityPreconditioner<T>(a.get_row_count()), options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_gmres(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options, KrylovWorkspace<T>& workspace) {
+		return solve_gmres(a, b, x, IdentityPreconditioner<T>(a.get_row_count()), options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_cg(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_cg(a, b, x, options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_bicgstab(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_bicgstab(a, b, x, options, workspace);
+	}
+	template<Numerical_Inexact T, LinearOperator<T> Operator>
+	static IterativeReport solve_gmres(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options = {}) {
+		KrylovWorkspace<T> workspace;
+		return solve_gmres(a, b, x, options, workspace);
+	}
+
+private:
+	template<Numerical T, typename Operator>
+	static int prepare_solve(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options, IterativeReport& report);
+	static bool record_residual(double residual, double target, const IterativeOptions& options, IterativeReport& report);
+	static void finish(IterativeReport& report, std::chrono::steady_clock::time_point start) {
+		if (!report.residual_history.empty())
+			report.final_residual = report.residual_history.back();
+		report.wall_time_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	// r = b - A * x
+	template<Numerical T, typename Operator>
+	static void residual(const Operator& a, const T* b, const T* x, T* r, int n) {
+		a.multiply(x, r);
+		for (int i = 0; i < n; i++)
+			r[i] = b[i] - r[i];
+	}
+
+	template<Numerical T>
+	static T conjugate(const T& x) {
+		if constexpr (requires { std::conj(x); } && !std::is_arithmetic_v<T>)
+			return std::conj(x);
+		else
+			return x;
+	}
+	// inner product <x, y> = sum conj(x_i) * y_i
+	template<Numerical T>
+	static T inner_product(int n, const T* x, const T* y) {
+		T sum = 0;
+		for (int i = 0; i < n; i++)
+			sum = sum + conjugate(x[i]) * y[i];
+		return sum;
+	}
+	template<Numerical T>
+	static double magnitude(const T& x) {
+		using std::abs;
+		return static_cast<double>(abs(x));
+	}
+	template<Numerical T>
+	static double norm(int n, const T* x) {
+		double sum = 0;
+		for (int i = 0; i < n; i++) {
+			double m = magnitude(x[i]);
+			sum += m * m;
+		}
+		return std::sqrt(sum);
+	}
+};
+
+// Checks dimensions, sets up x and the report, returns the size of the system
+template<Numerical T, typename Operator>
+int IterativeSolver::prepare_solve(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const IterativeOptions& options, IterativeReport& report)
+{
+	int n = a.get_row_count();
+	if (b.get_row_count() != n || b.get_column_count() != 1)
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect dimensions");
+	if (x.get_row_count() != n || x.get_column_count() != 1) {
+		x.resize(n, 1);
+		std::fill(x.data(), x.data() + n, T(0));
+	}
+	if (options.record_history)
+		report.residual_history.reserve(options.max_iterations + 1);
+	return n;
+}
+
+// Stores the residual norm of the current iteration, returns true when the target is reached
+inline bool IterativeSolver::record_residual(double residual, double target, const IterativeOptions& options, IterativeReport& report)
+{
+	if (options.record_history || report.residual_history.empty())
+		report.residual_history.push_back(residual);
+	else
+		report.residual_history.back() = residual;
+	report.converged = residual <= target;
+	return report.converged;
+}
+
+template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+IterativeReport IterativeSolver::solve_cg(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace)
+{
+	auto start = std::chrono::steady_clock::now();
+	IterativeReport report;
+	int n = prepare_solve(a, b, x, options, report);
+	workspace.prepare(n, 4);
+	T* r = workspace.vector(0);
+	T* p = workspace.vector(1);
+	T* ap = workspace.vector(2);
+	T* z = workspace.vector(3);
+	T* solution = x.data();
+
+	double target = options.tolerance * norm(n, b.data());
+	residual(a, b.data(), solution, r, n);
+	if (record_residual(norm(n, r), target, options, report)) {
+		finish(report, start);
+		return report;
+	}
+	preconditioner.apply(r, z);
+	std::copy(z, z + n, p);
+	T rz = inner_product(n, r, z);
+
+	while (report.iterations < options.max_iterations) {
+		a.multiply(p, ap);
+		T pap = inner_product(n, p, ap);
+		if (pap == 0)
+			break;
+		T alpha = rz / pap;
+		VectorKernels<T>::axpy(n, alpha, p, solution);
+		VectorKernels<T>::axpy(n, -alpha, ap, r);
+		report.iterations++;
+		if (record_residual(norm(n, r), target, options, report))
+			break;
+		preconditioner.apply(r, z);
+		T rz_new = inner_product(n, r, z);
+		// p = z + beta * p
+		VectorKernels<T>::row_update(n, T(1), z, rz_new / rz, p);
+		rz = rz_new;
+	}
+	finish(report, start);
+	return report;
+}
+
+template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+IterativeReport IterativeSolver::solve_bicgstab(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace)
+{
+	auto start = std::chrono::steady_clock::now();
+	IterativeReport report;
+	int n = prepare_solve(a, b, x, options, report);
+	workspace.prepare(n, 8);
+	T* r = workspace.vector(0);
+	T* r_hat = workspace.vector(1);
+	T* p = workspace.vector(2);
+	T* v = workspace.vector(3);
+	T* s = workspace.vector(4);
+	T* t = workspace.vector(5);
+	// p and s with the preconditioner applied
+	T* p_hat = workspace.vector(6);
+	T* s_hat = workspace.vector(7);
+	T* solution = x.data();
+
+	double target = options.tolerance * norm(n, b.data());
+	residual(a, b.data(), solution, r, n);
+	if (record_residual(norm(n, r), target, options, report)) {
+		finish(report, start);
+		return report;
+	}
+	std::copy(r, r + n, r_hat);
+	std::fill(p, p + n, T(0));
+	std::fill(v, v + n, T(0));
+	T rho = 1, alpha = 1, omega = 1;
+
+	while (report.iterations < options.max_iterations) {
+		T rho_new = inner_product(n, r_hat, r);
+		// breakdown, the shadow residual became orthogonal to the residual
+		if (rho_new == 0)
+			break;
+		T beta = (rho_new / rho) * (alpha / omega);
+		// p = r + beta * (p - omega * v)
+		VectorKernels<T>::axpy(n, -omega, v, p);
+		VectorKernels<T>::row_update(n, T(1), r, beta, p);
+		preconditioner.apply(p, p_hat);
+		a.multiply(p_hat, v);
+		T r_hat_v = inner_product(n, r_hat, v);
+		if (r_hat_v == 0)
+			break;
+		alpha = rho_new / r_hat_v;
+		// s = r - alpha * v
+		std::copy(r, r + n, s);
+		VectorKernels<T>::axpy(n, -alpha, v, s);
+		report.iterations++;
+		double s_norm = norm(n, s);
+		if (s_norm <= target) {
+			VectorKernels<T>::axpy(n, alpha, p_hat, solution);
+			record_residual(s_norm, target, options, report);
+			break;
+		}
+		preconditioner.apply(s, s_hat);
+		a.multiply(s_hat, t);
+		T tt = inner_product(n, t, t);
+		if (tt == 0)
+			break;
+		omega = inner_product(n, t, s) / tt;
+		VectorKernels<T>::axpy(n, alpha, p_hat, solution);
+		VectorKernels<T>::axpy(n, omega, s_hat, solution);
+		// r = s - omega * t
+		std::copy(s, s + n, r);
+		VectorKernels<T>::axpy(n, -omega, t, r);
+		if (record_residual(norm(n, r), target, options, report) || omega == 0)
+			break;
+		rho = rho_new;
+	}
+	finish(report, start);
+	return report;
+}
+
+// GMRES(m): the basis of the Krylov subspace is built by modified Gram-Schmidt, the Hessenberg matrix is reduced
+// to upper triangular form by Givens rotations as it grows, so the residual norm is known in every iteration without forming x
+// With right preconditioning the basis is built for A * M^-1 and the update of x is M^-1 * V * y
+template<Numerical_Inexact T, LinearOperator<T> Operator, Preconditioner<T> P>
+IterativeReport IterativeSolver::solve_gmres(const Operator& a, const Matrix<T>& b, Matrix<T>& x, const P& preconditioner, const IterativeOptions& options, KrylovWorkspace<T>& workspace)
+{
+	auto start = std::chrono::steady_clock::now();
+	IterativeReport report;
+	int n = prepare_solve(a, b, x, options, report);
+	int m = std::max(1, std::min(options.restart, n));
+	workspace.prepare_gmres(n, m);
+	Matrix<T>& h = workspace._hessenberg;
+	std::vector<T>& cosines = workspace._cosines;
+	std::vector<T>& sines = workspace._sines;
+	std::vector<T>& g = workspace._reduced;
+	T* w = workspace.vector(m + 1);
+	T* z = workspace.vector(m + 2);
+	T* solution = x.data();
+
+	double target = options.tolerance * norm(n, b.data());
+	while (true) {
+		// the residual of every restart is computed from x, it replaces the estimate recorded by the last iteration
+		T* v0 = workspace.vector(0);
+		residual(a, b.data(), solution, v0, n);
+		double beta = norm(n, v0);
+		if (report.iterations > 0)
+			report.residual_history.pop_back();
+		record_residual(beta, target, options, report);
+		if (report.converged || report.iterations >= options.max_iterations || beta == 0)
+			break;
+		for (int i = 0; i < n; i++)
+			v0[i] = v0[i] / T(beta);
+		std::fill(g.begin(), g.end(), T(0));
+		g[0] = T(beta);
+
+		int k = 0;
+		while (k < m && report.iterations < options.max_iterations) {
+			preconditioner.apply(workspace.vector(k), z);
+			a.multiply(z, w);
+			for (int i = 0; i <= k; i++) {
+				T* vi = workspace.vector(i);
+				h(i, k) = inner_product(n, vi, w);
+				VectorKernels<T>::axpy(n, -h(i, k), vi, w);
+			}
+			double w_norm = norm(n, w);
+			h(k + 1, k) = T(w_norm);
+			if (w_norm != 0) {
+				T* next = workspace.vector(k + 1);
+				for (int i = 0; i < n; i++)
+					next[i] = w[i] / T(w_norm);
+			}
+
+			// previous rotations, then a new one eliminating h(k + 1, k)
+			for (int i = 0; i < k; i++) {
+				T upper = h(i, k), lower = h(i + 1, k);
+				h(i, k) = conjugate(cosines[i]) * upper + conjugate(sines[i]) * lower;
+				h(i + 1, k) = -sines[i] * upper + cosines[i] * lower;
+			}
+			double diagonal = magnitude(h(k, k));
+			double denominator = std::sqrt(diagonal * diagonal + w_norm * w_norm);
+			if (denominator == 0) {
+				cosines[k] = T(1);
+				sines[k] = T(0);
+			}
+			else {
+				cosines[k] = h(k, k) / T(denominator);
+				sines[k] = T(w_norm / denominator);
+			}
+			h(k, k) = T(denominator);
+			h(k + 1, k) = T(0);
+			g[k + 1] = -sines[k] * g[k];
+			g[k] = conjugate(cosines[k]) * g[k];
+
+			k++;
+			report.iterations++;
+			// the residual norm of the current iterate is |g[k]|
+			if (record_residual(magnitude(g[k]), target, options, report) || w_norm == 0)
+				break;
+		}
+
+		// x += V * y where H * y = g (upper triangular k x k)
+		for (int i = k - 1; i >= 0; i--) {
+			T sum = g[i];
+			for (int j = i + 1; j < k; j++)
+				sum = sum - h(i, j) * g[j];
+			g[i] = h(i, i) == 0 ? T(0) : sum / h(i, i);
+		}
+		std::fill(w, w + n, T(0));
+		for (int i = 0; i < k; i++)
+			VectorKernels<T>::axpy(n, g[i], workspace.vector(i), w);
+		preconditioner.apply(w, z);
+		VectorKernels<T>::axpy(n, T(1), z, solution);
+	}
+	finish(report, start);
+	return report;
+}
@@ -1,79 +1,449 @@
 // LinSolver.h
 // Both declarations and definitions of all the linear equation system solver functions and decomposition functions
+// Inner loops are written with the kernels of VectorKernels<T> (simd_kernels.h), which are vectorized for double, float and complex<double>
+// solve_lu_refined factorizes in float and refines the solution to double accuracy, the mixed precision variant of solve_lu
+// solve_lu of complex<double> systems factorizes them in the split layout of SplitComplexMatrix (real and imaginary parts in separate planes)
+// LinSolver::solve analyses the structure of the matrix in one pass and picks the cheapest applicable algorithm by itself
 
 #pragma once
 #include<vector>
+#include<array>
+#include<numeric>
+#include<cmath>
+#include<type_traits>
+#include<limits>
 
 #include "Matrix.h"
+#include "PackedSymmetricMatrix.h"
+#include "BandedMatrix.h"
+#include "FixedMatrix.h"
+#include "SparseMatrix.h"
+#include "SplitComplexMatrix.h"
+#include "IterativeSolver.h"
+#include "Blas.h"
+#include "simd_kernels.h"
+#include "thread_pool.h"
+#include "GaussSeidel.h"
 
-// System Solver Exceptions
-// thrown when errors occur when solving the system
-// for eg. when the system is not solvable, or when the system is not square
-class SystemSolverException : public LinSolveBaseException {
-public:
-	SystemSolverException(const std::string& message) : e_message(message) {}
-	virtual const char* what() const throw() { return e_message.c_str(); }
-private:
-	std::string e_message;
+// Algorithms LinSolver::solve can choose from, in the order they are tried
+enum class SolverMethod { Triangular, Tridiagonal, Banded, Iterative, Cholesky, LDLT, LU };
+
+inline const char* solver_method_name(const SolverMethod method)
+{
+	switch (method) {
+	case SolverMethod::Triangular: return "triangular substitution";
+	case SolverMethod::Tridiagonal: return "Thomas algorithm";
+	case SolverMethod::Banded: return "banded LU";
+	case SolverMethod::Iterative: return "preconditioned Krylov method";
+	case SolverMethod::Cholesky: return "Cholesky";
+	case SolverMethod::LDLT: return "LDL^T";
+	default: return "LU";
+	}
+}
+
+// Structure of a square matrix found by LinSolver::analyze
+struct MatrixStructure {
+	int size = 0;
+	bool symmetric = false;
+	bool lower_triangular = false;
+	bool upper_triangular = false;
+	// largest i - j (j - i) of a nonzero element (i, j) below (above) the diagonal
+	int lower_bandwidth = 0;
+	int upper_bandwidth = 0;
+	long long nonzero_count = 0;
+	// nonzero_count / size^2
+	double density = 0;
+	// |A(i, i)| >= sum of |A(i, j)| over the other elements of the row, for every row
+	bool diagonally_dominant = false;
+	// every diagonal element is greater than zero (for complex numbers nonzero, they are compared by absolute value)
+	bool positive_diagonal = false;
+};
+
+// Solution of LinSolver::solve together with the algorithm that computed it and the structure it was chosen by
+template<Numerical T>
+struct SolveResult {
+	Matrix<T> solution;
+	SolverMethod method = SolverMethod::LU;
+	MatrixStructure structure;
 };
 
 class LinSolver {
 public:
+	// solves the system (n x n+1 matrix) by the cheapest algorithm applicable to its matrix
+	template<Numerical T>
+	static SolveResult<T> solve(const Matrix<T>& system);
+	// one O(n^2) pass over the matrix
+	template<Numerical T>
+	static MatrixStructure analyze(const MatrixView<const T>& matrix);
 	template<Numerical T>
 	static Matrix<T> solve_elimination(const Matrix<T>& system);
 	template<Numerical T>
 	static Matrix<T> solve_lu(const Matrix<T>& system);
+	// LU factorization in the lower precision Low refined to the accuracy of T, falls back to solve_lu when the refinement does not converge
+	template<Numerical_Inexact T, Numerical_Inexact Low = float> requires std::floating_point<T> && std::floating_point<Low>
+	static Matrix<T> solve_lu_refined(const Matrix<T>& system, const int max_iterations = 30);
 	template<Numerical T>
-	static Matrix<T> solve_gauss_seidel(const Matrix<T>& system, const int max_steps = 10000, const T accuracy = T(0));
+	static Matrix<T> solve_gauss_seidel(const Matrix<T>& system, const int max_steps = 10000, const T accuracy = T(0), const T relaxation = T(1), const int check_interval = 8);
 	template<Numerical_WithSqrt T>
 	static Matrix<T> solve_qr(const Matrix<T>& system);
+	template<Numerical_WithSqrt T>
+	static Matrix<T> solve_cholesky(const Matrix<T>& system, const int block_size = 128);
+	// the packed matrix is overwritten by its Cholesky factor, so no other copy of the matrix is made
+	template<Numerical_WithSqrt T>
+	static Matrix<T> solve_cholesky(PackedSymmetricMatrix<T>& matrix, const Matrix<T>& b, const int block_size = 128);
+	template<Numerical_WithSqrt T>
+	static Matrix<T> solve_ldlt(const Matrix<T>& system);
+	template<Numerical T>
+	static Matrix<T> solve_banded(const BandedMatrix<T>& matrix, const Matrix<T>& b);
+	template<Numerical T>
+	static std::vector<T> solve_tridiagonal(const std::vector<T>& sub, const std::vector<T>& diagonal, const std::vector<T>& super, const std::vector<T>& b);
 	template<Numerical T>
 	static void LU_decompose(Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper, Matrix<T>& b);
 	template<Numerical T>
+	static void LU_decompose_blocked(Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper, Matrix<T>& b, const int block_size = 64);
+	template<Numerical T>
+	static void LU_factorize(Matrix<T>& input, std::vector<int>& row_order, const int block_size = 64);
+	// same blocked algorithm and layout of the factors in the planes of a split complex matrix
+	static void LU_factorize(SplitComplexMatrix& input, std::vector<int>& row_order, const int block_size = 64);
+	// solves A * X = B with the factors of LU_factorize, b holds B (any number of columns) on input and X on output
+	static void LU_solve(const SplitComplexMatrix& factors, const std::vector<int>& row_order, SplitComplexMatrix& b);
+	// fixed size systems (FixedMatrix.h), same algorithms with all loops unrolled and no heap allocations
+	template<Numerical T, int N>
+	static constexpr FixedMatrix<T, N, 1> solve_elimination(const FixedMatrix<T, N, N + 1>& system);
+	template<Numerical T, int N>
+	static constexpr FixedMatrix<T, N, 1> solve_lu(const FixedMatrix<T, N, N + 1>& system);
+	template<Numerical T, int N>
+	static constexpr void LU_factorize(FixedMatrix<T, N, N>& input, std::type_identity_t<std::array<int, N>>& row_order);
+	template<Numerical T>
+	static void solve_triangular(const MatrixView<const T>& triangle, const MatrixView<T>& x, const bool lower, const bool unit_diagonal, const int block_size = 64);
+	template<Numerical T>
 	static Matrix<T> permutation_vector(const int size);
 	template<Numerical T>
 	static Matrix<T> permuation_vector_to_matrix(const Matrix<T>& p_vector);
 	template<Numerical_WithSqrt T>
 	static void QR_decompose(const Matrix<T>& input, Matrix<T>& q, Matrix<T>& r);
+	template<Numerical_WithSqrt T>
+	static void QR_factorize(Matrix<T>& input, std::vector<T>& tau, const int block_size = 32);
+	template<Numerical_WithSqrt T>
+	static void QR_apply_qt(const Matrix<T>& factors, const std::vector<T>& tau, const MatrixView<T>& b, const int block_size = 32);
+	template<Numerical_WithSqrt T>
+	static Matrix<T> QR_form_q(const Matrix<T>& factors, const std::vector<T>& tau, const int block_size = 32);
+	template<Numerical_WithSqrt T>
+	static void cholesky_factorize(Matrix<T>& input, const int block_size = 128);
+	template<Numerical_WithSqrt T>
+	static void cholesky_factorize(PackedSymmetricMatrix<T>& input, const int block_size = 128);
+	template<Numerical T>
+	static void cholesky_solve(const Matrix<T>& factor, const MatrixView<T>& b);
+	template<Numerical T>
+	static void cholesky_solve(const PackedSymmetricMatrix<T>& factor, const MatrixView<T>& b);
+	template<Numerical_WithSqrt T>
+	static void ldlt_factorize(Matrix<T>& input, std::vector<int>& row_order, std::vector<int>& pivot_sizes);
+	template<Numerical T>
+	static void ldlt_solve(const Matrix<T>& factors, const std::vector<int>& row_order, const std::vector<int>& pivot_sizes, const MatrixView<T>& b);
+	template<Numerical T>
+	static void banded_LU_factorize(BandedMatrix<T>& input, std::vector<int>& pivots);
+	template<Numerical T>
+	static void banded_LU_solve(const BandedMatrix<T>& factors, const std::vector<int>& pivots, const MatrixView<T>& b);
 private:
+	// the solution is written to x, which may be b itself
 	template<Numerical T>
-	static Matrix<T> forward_substitution(const Matrix<T>& matrix, const Matrix<T>& b);
+	static void forward_substitution(const MatrixView<const T>& matrix, const MatrixView<const T>& b, const MatrixView<T>& x);
 	template<Numerical T>
-	static Matrix<T> back_substitution(const Matrix<T>& matrix, const Matrix<T>& b);
+	static void back_substitution(const MatrixView<const T>& matrix, const MatrixView<const T>& b, const MatrixView<T>& x);
+	// substitutions with the upper triangle of the first N columns, the right side is column N (fixed size elimination)
+	// or a separate vector (fixed size LU, where the lower triangle has a unit diagonal)
+	template<Numerical T, int N>
+	static constexpr FixedMatrix<T, N, 1> back_substitution(const FixedMatrix<T, N, N + 1>& system);
+	template<Numerical T, int N>
+	static constexpr FixedMatrix<T, N, 1> back_substitution(const FixedMatrix<T, N, N>& matrix, const FixedMatrix<T, N, 1>& b);
+	template<Numerical T, int N>
+	static constexpr FixedMatrix<T, N, 1> unit_forward_substitution(const FixedMatrix<T, N, N>& matrix, const FixedMatrix<T, N, 1>& b);
+	// key partial pivoting maximizes: |value|, for complex numbers |value|^2 (same order without the square root of abs)
+	// usable in constant expressions, std::abs is not constexpr for built-in types before C++23
 	template<Numerical T>
-	static void divide_system(const Matrix<T>& input, Matrix<T>& left, Matrix<T>& right);
+	static constexpr auto pivot_key(const T& value);
+	// complex conjugate, the identity for real types
 	template<Numerical T>
-	static int get_row_to_switch(Matrix<T>& input, const int column_idx);
+	static T conjugate(const T& value);
+	template<Numerical T>
+	static void divide_system(const Matrix<T>& input, MatrixView<const T>& left, MatrixView<const T>& right);
+	template<Numerical T>
+	static int get_row_to_switch(const MatrixView<const T>& input, const int column_idx);
 	template<Numerical T>
 	static void switch_rows(Matrix<T>& input, const int idx1, const int idx2);
 	template<Numerical T>
-	static void split_lu(const Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper);
+	static void permute_rows(Matrix<T>& input, const std::vector<int>& row_order);
 	template<Numerical T>
-	static bool gs_check_accuracy(const Matrix<T>& old_x, const Matrix<T>& new_x, T accuracy);
+	static void split_lu(const Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper);
 	template<Numerical_WithSqrt T>
 	static T dot_product(const std::vector<T>& x, const std::vector<T>& y);
 	template<Numerical_WithSqrt T>
 	static T vector_norm(const std::vector<T>& x);
 	template<Numerical_WithSqrt T>
-	static Matrix<T> householder_reflection(const std::vector<T>& x);
+	static void householder_panel(Matrix<T>& input, std::vector<T>& tau, const int first_column, const int end_column);
+	template<Numerical_WithSqrt T>
+	static Matrix<T> householder_block_triangle(const Matrix<T>& v, const std::vector<T>& tau, const int first_column);
+	template<Numerical_WithSqrt T>
+	static void apply_block_reflector(const MatrixView<const T>& factors, const std::vector<T>& tau, const int first_column, const int width, const MatrixView<T>& target, const bool transpose);
+	template<Numerical_WithSqrt T>
+	static void apply_householder(const MatrixView<const T>& factors, const T tau, const int column, const MatrixView<T>& target, std::vector<T>& work);
+	template<Numerical_WithSqrt T, typename RowAccess>
+	static void cholesky_row(const RowAccess& row, const int i, const int first_column, const int end_column, const int dot_start);
+	template<Numerical T, typename RowAccess>
+	static void lower_substitution(const RowAccess& row, const int size, const MatrixView<T>& b, const bool unit_diagonal);
+	template<Numerical T, typename RowAccess>
+	static void lower_transposed_substitution(const RowAccess& row, const int size, const MatrixView<T>& b, const bool unit_diagonal);
+	template<Numerical T>
+	static void symmetric_swap(Matrix<T>& input, const int p, const int q);
+	template<Numerical T>
+	static double pivot_magnitude(const T& value);
+	template<Numerical T, typename Sub, typename Diagonal, typename Super>
+	static bool thomas_algorithm(const int size, const Sub& sub, const Diagonal& diagonal, const Super& super, const MatrixView<T>& b, std::vector<T>& work);
+	template<Numerical T>
+	static bool is_diagonally_dominant(const BandedMatrix<T>& matrix);
+
+	// thresholds of the dispatch in solve
+	// matrices with lower + upper + 1 <= n / band_divisor are solved as banded
+	static constexpr int band_divisor = 4;
+	// the sparse iterative path is taken only for systems at least this large with at most this fraction of nonzero elements
+	static constexpr int iterative_min_size = 1000;
+	static constexpr double iterative_max_density = 0.05;
 };
 
+// The cheapest applicable algorithm is chosen by the structure of the matrix:
+// - triangular matrices are solved by substitution in O(n^2)
+// - matrices with a narrow band (lower + upper + 1 <= n / band_divisor) by the Thomas algorithm or banded LU in O(n * bandwidth^2)
+// - large sparse diagonally dominant matrices by CG (symmetric) or BiCGSTAB preconditioned by ILU(0), which converge fast for them;
+//   if the iteration does not converge, the system is solved by LU
+// - symmetric matrices by Cholesky (floating point types with positive diagonal, half the work of LU) or LDL^T
+// - everything else by LU
+// The analysis costs one pass over the matrix, which is negligible next to the O(n^3) of the dense factorizations
 template<Numerical T>
-Matrix<T> LinSolver::solve_lu(const Matrix<T>& system) {
-	Matrix<T> left, lower, upper, b;
+SolveResult<T> LinSolver::solve(const Matrix<T>& system)
+{
+	MatrixView<const T> left, b;
 	divide_system(system, left, b);
+	if (!left.is_square())
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+
+	SolveResult<T> result;
+	result.structure = analyze<T>(left);
+	const MatrixStructure& structure = result.structure;
+	int size = structure.size;
 
-	LU_decompose(left, lower, upper, b);
-	Matrix<T> temp = forward_substitution(lower, b);
-	Matrix<T> result = back_substitution(upper, temp);
+	if (structure.lower_triangular || structure.upper_triangular) {
+		result.method = SolverMethod::Triangular;
+		result.solution = Matrix<T>(b);
+		solve_triangular<T>(left, result.solution.get_view(), structure.lower_triangular, false);
+		return result;
+	}
+
+	int lower = structure.lower_bandwidth, upper = structure.upper_bandwidth;
+	if ((lower + upper + 1) * band_divisor <= size) {
+		BandedMatrix<T> banded(size, lower, upper);
+		for (int i = 0; i < size; i++)
+			for (int j = std::max(0, i - lower); j <= std::min(size - 1, i + upper); j++)
+				banded(i, j) = left[i][j];
+		result.method = banded.is_tridiagonal() && structure.diagonally_dominant ? SolverMethod::Tridiagonal : SolverMethod::Banded;
+		result.solution = solve_banded(banded, Matrix<T>(b));
+		return result;
+	}
+
+	if constexpr (Numerical_Inexact<T>) {
+		if (size >= iterative_min_size && structure.density <= iterative_max_density && structure.diagonally_dominant && structure.positive_diagonal) {
+			std::vector<int> row_starts(size + 1, 0), columns;
+			std::vector<T> values;
+			columns.reserve(structure.nonzero_count);
+			values.reserve(structure.nonzero_count);
+			for (int i = 0; i < size; i++) {
+				for (int j = 0; j < size; j++) {
+					T value = left[i][j];
+					if (value == 0)
+						continue;
+					columns.push_back(j);
+					values.push_back(value);
+				}
+				row_starts[i + 1] = static_cast<int>(values.size());
+			}
+			SparseMatrix<T> sparse(size, size, std::move(row_starts), std::move(columns), std::move(values));
+			Matrix<T> rhs(b), x(size, 1);
+			IterativeOptions options;
+			options.record_history = false;
+			try {
+				ILU0Preconditioner<T> preconditioner(sparse);
+				// CG needs a hermitian matrix, complex symmetric matrices are left to BiCGSTAB
+				IterativeReport report = structure.symmetric && std::is_arithmetic_v<T> ? IterativeSolver::solve_cg(sparse, rhs, x, preconditioner, options)
+					: IterativeSolver::solve_bicgstab(sparse, rhs, x, preconditioner, options);
+				if (report.converged) {
+					result.method = SolverMethod::Iterative;
+					result.solution = std::move(x);
+					return result;
+				}
+			}
+			// zero pivot of ILU(0), the direct methods below are used instead
+			catch (const SystemSolverException&) {}
+		}
+	}
+
+	if constexpr (Numerical_WithSqrt<T>) {
+		if (structure.symmetric) {
+			// the square roots of Cholesky would make the result of exact types (Fraction) inexact, LDL^T does not take any
+			// Cholesky is only for real matrices: for complex ones positive_diagonal only means a nonzero diagonal,
+			// and complex symmetric matrices are not positive definite, they need the pivoting of LDL^T
+			if (std::is_arithmetic_v<T> && Numerical_Inexact<T> && structure.positive_diagonal) {
+				// a positive diagonal is necessary but not sufficient for positive definiteness, Cholesky finds out on the way
+				try {
+					result.method = SolverMethod::Cholesky;
+					result.solution = solve_cholesky(system);
+					return result;
+				}
+				catch (const SystemSolverException&) {}
+			}
+			result.method = SolverMethod::LDLT;
+			result.solution = solve_ldlt(system);
+			return result;
+		}
+	}
+
+	result.method = SolverMethod::LU;
+	result.solution = solve_lu(system);
 	return result;
 }
 
+template<Numerical T>
+MatrixStructure LinSolver::analyze(const MatrixView<const T>& matrix)
+{
+	using std::abs;
+	if (!matrix.is_square())
+		throw SystemSolverException("Error: cannot analyse matrix, matrix is not square");
+	MatrixStructure structure;
+	int size = matrix.get_row_count();
+	structure.size = size;
+	structure.symmetric = true;
+	structure.diagonally_dominant = true;
+	structure.positive_diagonal = true;
+
+	for (int i = 0; i < size; i++) {
+		const T* row = matrix[i];
+		T off_diagonal = 0;
+		for (int j = 0; j < size; j++) {
+			T value = row[j];
+			// the element below the diagonal is compared with its mirror, so every pair is checked once
+			if (j < i && structure.symmetric && !(value == matrix[j][i]))
+				structure.symmetric = false;
+			if (value == 0)
+				continue;
+			structure.nonzero_count++;
+			if (j < i)
+				structure.lower_bandwidth = std::max(structure.lower_bandwidth, i - j);
+			else if (j > i)
+				structure.upper_bandwidth = std::max(structure.upper_bandwidth, j - i);
+			if (j != i)
+				off_diagonal = off_diagonal + abs(value);
+		}
+		T diagonal = row[i];
+		if (abs(diagonal) < off_diagonal)
+			structure.diagonally_dominant = false;
+		if (!(T(0) < diagonal))
+			structure.positive_diagonal = false;
+	}
+
+	structure.lower_triangular = structure.upper_bandwidth == 0;
+	structure.upper_triangular = structure.lower_bandwidth == 0;
+	structure.density = size > 0 ? static_cast<double>(structure.nonzero_count) / (static_cast<double>(size) * size) : 0;
+	return structure;
+}
+
+template<Numerical T>
+Matrix<T> LinSolver::solve_lu(const Matrix<T>& system) {
+	MatrixView<const T> left_view, b_view;
+	divide_system(system, left_view, b_view);
+	if constexpr (std::is_same_v<T, std::complex<double>>) {
+		// checked before the conversion to the split layout
+		if (!left_view.is_square())
+			throw SystemSolverException("Error: cannot LU decompose input matrix, input matrix is not square");
+		SplitComplexMatrix factors(left_view), b(b_view);
+		std::vector<int> row_order;
+		LU_factorize(factors, row_order);
+		LU_solve(factors, row_order, b);
+		return b.to_complex();
+	}
+	else {
+		Matrix<T> left(left_view), b(b_view), lower, upper;
+
+		LU_decompose_blocked(left, lower, upper, b);
+		forward_substitution<T>(lower.get_view(), b.get_view(), b.get_view());
+		back_substitution<T>(upper.get_view(), b.get_view(), b.get_view());
+		return b;
+	}
+}
+
+// Mixed precision LU for floating point types (iterative refinement as in LAPACK dsgesv): the O(n^3) factorization is done by LU_factorize in Low,
+// which moves half the memory and fits twice the elements into a SIMD register, only the O(n^2) steps are done in T
+// Every iteration computes the residual r = b - A * x in T, solves A * d = r with the Low factors and updates x = x + d
+// The refinement stops when ||r|| <= ||A|| * ||x|| * eps * sqrt(n) (infinity norms, eps of T), the accuracy of a direct solve in T;
+// if it does not get there in max_iterations (the condition number is near 1 / eps of Low) or the Low factors are not finite,
+// the system is solved again by solve_lu in T
+template<Numerical_Inexact T, Numerical_Inexact Low> requires std::floating_point<T> && std::floating_point<Low>
+Matrix<T> LinSolver::solve_lu_refined(const Matrix<T>& system, const int max_iterations)
+{
+	MatrixView<const T> left_view, b_view;
+	divide_system(system, left_view, b_view);
+	Matrix<T> left(left_view), b(b_view);
+	if (!left.is_square())
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+
+	int size = left.get_row_count();
+	Matrix<Low> factors(left);
+	std::vector<int> row_order;
+	LU_factorize(factors, row_order);
+	bool finite = true;
+	for (int i = 0; i < size; i++)
+		finite = finite && std::isfinite(factors[i][i]) && factors[i][i] != 0;
+
+	T matrix_norm = 0;
+	for (int i = 0; i < size; i++) {
+		T row_sum = 0;
+		for (int j = 0; j < size; j++)
+			row_sum += std::abs(left[i][j]);
+		matrix_norm = std::max(matrix_norm, row_sum);
+	}
+	T tolerance = matrix_norm * std::numeric_limits<T>::epsilon() * std::sqrt(static_cast<T>(size));
+
+	Matrix<T> x(size, 1), residual(b), product(size, 1);
+	Matrix<Low> correction(size, 1);
+	for (int iteration = 0; finite && iteration < max_iterations; iteration++) {
+		// d = U^-1 * L^-1 * P * r
+		for (int i = 0; i < size; i++)
+			correction(i) = static_cast<Low>(residual(row_order[i]));
+		solve_triangular<Low>(factors.get_view(), correction.get_view(), true, true);
+		solve_triangular<Low>(factors.get_view(), correction.get_view(), false, false);
+
+		T x_norm = 0;
+		for (int i = 0; i < size; i++) {
+			x(i) = x(i) + static_cast<T>(correction(i));
+			x_norm = std::max(x_norm, std::abs(x(i)));
+		}
+		left.multiply(x.data(), product.data());
+		T residual_norm = 0;
+		for (int i = 0; i < size; i++) {
+			residual(i) = b(i) - product(i);
+			residual_norm = std::max(residual_norm, std::abs(residual(i)));
+		}
+		if (!std::isfinite(residual_norm))
+			break;
+		if (residual_norm <= x_norm * tolerance)
+			return x;
+	}
+	return solve_lu(system);
+}
+
 template<Numerical T>
 Matrix<T> LinSolver::solve_elimination(const Matrix<T>& system)
 {
-	Matrix<T> matrix, b;
-	divide_system(system, matrix, b);
+	MatrixView<const T> matrix_view, b_view;
+	divide_system(system, matrix_view, b_view);
+	Matrix<T> matrix(matrix_view), b(b_view);
 	if(!matrix.is_square())
 		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
 
@@ -84,58 +454,47 @@ Matrix<T> LinSolver::solve_elimination(const Matrix<T>& system)
 			T val1 = -matrix[j][i];
 			T val2 = matrix[i][i];
 			matrix[j][i] = 0;
-			for (int k = i + 1; k < row_count; k++)
-				matrix[j][k] = val1 * matrix[i][k] + val2 * matrix[j][k];
+			VectorKernels<T>::row_update(row_count - i - 1, val1, matrix[i] + i + 1, val2, matrix[j] + i + 1);
 			b(j) = val1 * b(i) + val2 * b(j);
 		}
 
-	return back_substitution(matrix, b);
+	back_substitution<T>(matrix.get_view(), b.get_view(), b.get_view());
+	return b;
 }
 
+// Gauss-Seidel, with relaxation != 1 the SOR method, computed by GaussSeidel<T> on the CSR form of the matrix
+// (multicolor ordering, rows of one color are updated in parallel); the stopping rule is described at GaussSeidelOptions
 template<Numerical T>
-Matrix<T> LinSolver::solve_gauss_seidel(const Matrix<T>& system, const int max_steps, const T accuracy)
+Matrix<T> LinSolver::solve_gauss_seidel(const Matrix<T>& system, const int max_steps, const T accuracy, const T relaxation, const int check_interval)
 {
-	Matrix<T> matrix, b;
+	MatrixView<const T> matrix, b;
 	divide_system(system, matrix, b);
-	int row_count = matrix.get_row_count();
-	Matrix<T> x(row_count, 1);
-	
-	if (!matrix.is_square())
-		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
-	for (int i = 0; i < row_count; i++)
-		if(matrix[i][i] == 0)
-			throw SystemSolverException("Error: cannot compute Gauss Seidel algorithm, zero on the input matrixs diagonal");
-
-	for (int step = 0; step < max_steps; step++)
-	{
-		Matrix<T> old_x(row_count, 1);
-		for (int i = 0; i < row_count; i++)
-			old_x(i) = x(i);
-		for (int i = 0; i < row_count; i++)
-		{
-			T dot = 0;
-			for (int j = 0; j < row_count; j++)
-				if (i != j) dot = dot + matrix[i][j] * x(j);
-			x(i) = (b(i) - dot) / matrix[i][i];
-		}
-
-		if (gs_check_accuracy(old_x, x, accuracy))
-			return x;
-	}
 
+	GaussSeidelOptions<T> options;
+	options.relaxation = relaxation;
+	options.max_steps = max_steps;
+	options.accuracy = accuracy;
+	options.check_interval = check_interval;
+	GaussSeidel<T> gauss_seidel(Matrix<T>(matrix), options);
+	Matrix<T> x;
+	gauss_seidel.solve(Matrix<T>(b), x);
 	return x;
 }
 
 template<Numerical_WithSqrt T>
 Matrix<T> LinSolver::solve_qr(const Matrix<T>& system)
 {
-	Matrix<T> left, b, q, r;
-	divide_system(system, left, b);
-	QR_decompose(left, q, r);
+	MatrixView<const T> left_view, b_view;
+	divide_system(system, left_view, b_view);
+	Matrix<T> left(left_view), b(b_view);
+	std::vector<T> tau;
+	QR_factorize(left, tau);
 
-	auto y = q.transpose() * b;
-	Matrix<T> result = back_substitution(r, y);
-	return result;
+	// Q^H * b is computed by applying the reflectors to b, Q is never formed
+	// back substitution reads only the upper triangle, which holds R
+	QR_apply_qt(left, tau, b.get_view());
+	back_substitution<T>(left.get_view(), b.get_view(), b.get_view());
+	return b;
 }
 
 template<Numerical T>
@@ -146,7 +505,7 @@ void LinSolver::LU_decompose(Matrix<T>& input, Matrix<T>& lower, Matrix<T>& uppe
 
 	int num_rows = input.get_row_count();
 	for (int i = 0; i < num_rows; i++) {
-		int max_row = get_row_to_switch(input, i);
+		int max_row = get_row_to_switch<T>(input.get_view(), i);
 		if (max_row != i) {
 			switch_rows(input, i, max_row);
 			switch_rows(b, i, max_row);
@@ -154,14 +513,233 @@ void LinSolver::LU_decompose(Matrix<T>& input, Matrix<T>& lower, Matrix<T>& uppe
 		for (int j = i + 1; j < num_rows; j++)
 		{
 			input[j][i] = input[j][i] / input[i][i];
-			for (int k = i + 1; k < num_rows; k++)
-				input[j][k] = input[j][k] - input[j][i] * input[i][k];
+			VectorKernels<T>::axpy(num_rows - i - 1, -input[j][i], input[i] + i + 1, input[j] + i + 1);
 		}
 	}
 
 	split_lu(input, lower, upper);
 }
 
+// Blocked right-looking LU decomposition, computes the same factors and row switches as LU_decompose
+// The row switches are applied to b after the decomposition
+template<Numerical T>
+void LinSolver::LU_decompose_blocked(Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper, Matrix<T>& b, const int block_size)
+{
+	std::vector<int> row_order;
+	LU_factorize(input, row_order, block_size);
+	permute_rows(b, row_order);
+	split_lu(input, lower, upper);
+}
+
+// LU decomposition with partial pivoting done in place, the input is replaced by both factors (the unit diagonal of L is not stored)
+// row_order[i] is the index of the row of the original matrix that ended up in row i (P * A = L * U)
+// In every step a panel of block_size columns is factorized with partial pivoting (row switches are applied to whole rows),
+// then the block row right of the panel is solved with the unit lower triangle of the panel (U12 = L11^-1 * A12)
+// and the trailing submatrix is updated by a single matrix product (A22 = A22 - L21 * U12) computed by Gemm
+// Matrices with at most block_size rows are factorized as a single panel, which is the unblocked algorithm of LU_decompose
+template<Numerical T>
+void LinSolver::LU_factorize(Matrix<T>& input, std::vector<int>& row_order, const int block_size)
+{
+	if (!input.is_square())
+		throw SystemSolverException("Error: cannot LU decompose input matrix, input matrix is not square");
+
+	int num_rows = input.get_row_count();
+	int panel_width = block_size < 1 ? num_rows : block_size;
+	row_order.resize(num_rows);
+	for (int i = 0; i < num_rows; i++)
+		row_order[i] = i;
+
+	for (int panel = 0; panel < num_rows; panel += panel_width) {
+		int panel_end = std::min(panel + panel_width, num_rows);
+
+		// panel factorization, the updates are restricted to the columns of the panel
+		for (int i = panel; i < panel_end; i++) {
+			int max_row = get_row_to_switch<T>(input.get_view(), i);
+			if (max_row != i) {
+				switch_rows(input, i, max_row);
+				std::swap(row_order[i], row_order[max_row]);
+			}
+			for (int j = i + 1; j < num_rows; j++)
+			{
+				input[j][i] = input[j][i] / input[i][i];
+				VectorKernels<T>::axpy(panel_end - i - 1, -input[j][i], input[i] + i + 1, input[j] + i + 1);
+			}
+		}
+
+		int trailing = num_rows - panel_end;
+		if (trailing == 0)
+			break;
+
+		// U12 = L11^-1 * A12, forward substitution with the unit lower triangle of the panel, done row by row
+		for (int i = panel + 1; i < panel_end; i++)
+			for (int j = panel; j < i; j++)
+				VectorKernels<T>::axpy(trailing, -input[i][j], input[j] + panel_end, input[i] + panel_end);
+
+		// A22 = A22 - L21 * U12
+		Gemm::multiply<T>(input.get_submatrix(panel_end, panel, trailing, panel_end - panel), false,
+			input.get_submatrix(panel, panel_end, panel_end - panel, trailing), false,
+			input.get_submatrix(panel_end, panel_end, trailing, trailing), T(-1), T(1));
+	}
+}
+
+// The steps of LU_factorize for Matrix<T> on the planes: the pivot has the largest squared magnitude, row operations of the panel
+// and of the block row are SplitComplexKernels::axpy, and the trailing update is four real Gemm products
+inline void LinSolver::LU_factorize(SplitComplexMatrix& input, std::vector<int>& row_order, const int block_size)
+{
+	if (!input.is_square())
+		throw SystemSolverException("Error: cannot LU decompose input matrix, input matrix is not square");
+
+	int num_rows = input.get_row_count();
+	int panel_width = block_size < 1 ? num_rows : block_size;
+	row_order.resize(num_rows);
+	for (int i = 0; i < num_rows; i++)
+		row_order[i] = i;
+	Matrix<double>& re = input.get_real();
+	Matrix<double>& im = input.get_imag();
+
+	for (int panel = 0; panel < num_rows; panel += panel_width) {
+		int panel_end = std::min(panel + panel_width, num_rows);
+
+		for (int i = panel; i < panel_end; i++) {
+			int max_row = i;
+			double max_value = input.norm(i, i);
+			for (int j = i + 1; j < num_rows; j++)
+				if (max_value < input.norm(j, i)) {
+					max_value = input.norm(j, i);
+					max_row = j;
+				}
+			if (max_row != i) {
+				input.swap_rows(i, max_row);
+				std::swap(row_order[i], row_order[max_row]);
+			}
+			std::complex<double> pivot = input.get_value(i, i);
+			for (int j = i + 1; j < num_rows; j++) {
+				std::complex<double> multiplier = input.get_value(j, i) / pivot;
+				input.set_value(j, i, multiplier);
+				SplitComplexKernels::axpy(panel_end - i - 1, -multiplier, re[i] + i + 1, im[i] + i + 1, re[j] + i + 1, im[j] + i + 1);
+			}
+		}
+
+		int trailing = num_rows - panel_end;
+		if (trailing == 0)
+			break;
+
+		// U12 = L11^-1 * A12
+		for (int i = panel + 1; i < panel_end; i++)
+			for (int j = panel; j < i; j++)
+				SplitComplexKernels::axpy(trailing, -input.get_value(i, j), re[j] + panel_end, im[j] + panel_end, re[i] + panel_end, im[i] + panel_end);
+
+		// A22 = A22 - L21 * U12
+		const Matrix<double>& const_re = re;
+		const Matrix<double>& const_im = im;
+		SplitComplexMatrix::multiply(const_re.get_submatrix(panel_end, panel, trailing, panel_end - panel), const_im.get_submatrix(panel_end, panel, trailing, panel_end - panel),
+			const_re.get_submatrix(panel, panel_end, panel_end - panel, trailing), const_im.get_submatrix(panel, panel_end, panel_end - panel, trailing),
+			re.get_submatrix(panel_end, panel_end, trailing, trailing), im.get_submatrix(panel_end, panel_end, trailing, trailing), -1, 1);
+	}
+}
+
+// Every column of B is permuted and copied into contiguous vectors, then solved by forward substitution with the unit lower triangle
+// and back substitution with the upper triangle, the sums of both are SplitComplexKernels::dot over rows of the factors
+inline void LinSolver::LU_solve(const SplitComplexMatrix& factors, const std::vector<int>& row_order, SplitComplexMatrix& b)
+{
+	int row_count = factors.get_row_count();
+	if (!factors.is_square() || b.get_row_count() != row_count)
+		throw SystemSolverException("Error: cannot solve triangular system, incompatible dimensions");
+	const Matrix<double>& re = factors.get_real();
+	const Matrix<double>& im = factors.get_imag();
+	std::vector<double> x_re(row_count), x_im(row_count);
+
+	for (int column = 0; column < b.get_column_count(); column++) {
+		for (int i = 0; i < row_count; i++) {
+			std::complex<double> value = b.get_value(row_order[i], column);
+			std::complex<double> sum = SplitComplexKernels::dot(i, re[i], im[i], x_re.data(), x_im.data());
+			x_re[i] = value.real() - sum.real();
+			x_im[i] = value.imag() - sum.imag();
+		}
+		for (int i = row_count - 1; i >= 0; i--) {
+			std::complex<double> value(x_re[i], x_im[i]);
+			std::complex<double> diagonal = factors.get_value(i, i);
+			if (diagonal == 0)
+				value == 0 ?
+					throw SystemSolverException("Error: cannot compute back substituion, infinitely many solutions or unable to find solution") :
+					throw SystemSolverException("Error: cannot compute back substituion, no solution or unable to find solution");
+			std::complex<double> sum = SplitComplexKernels::dot(row_count - i - 1, re[i] + i + 1, im[i] + i + 1, x_re.data() + i + 1, x_im.data() + i + 1);
+			value = (value - sum) / diagonal;
+			x_re[i] = value.real();
+			x_im[i] = value.imag();
+		}
+		for (int i = 0; i < row_count; i++)
+			b.set_value(i, column, std::complex<double>(x_re[i], x_im[i]));
+	}
+}
+
+// Same elimination as solve_elimination (no pivoting, rows combined as a * row_j - b * row_i), unrolled for the fixed size
+template<Numerical T, int N>
+constexpr FixedMatrix<T, N, 1> LinSolver::solve_elimination(const FixedMatrix<T, N, N + 1>& system)
+{
+	FixedMatrix<T, N, N + 1> matrix(system);
+	static_for<0, N>([&](auto i) {
+		static_for<i + 1, N>([&](auto j) {
+			T val1 = -matrix[j][i];
+			T val2 = matrix[i][i];
+			matrix[j][i] = 0;
+			static_for<i + 1, N + 1>([&](auto k) { matrix[j][k] = val1 * matrix[i][k] + val2 * matrix[j][k]; });
+		});
+	});
+	return back_substitution(matrix);
+}
+
+template<Numerical T, int N>
+constexpr FixedMatrix<T, N, 1> LinSolver::solve_lu(const FixedMatrix<T, N, N + 1>& system)
+{
+	FixedMatrix<T, N, N> factors;
+	FixedMatrix<T, N, 1> b;
+	static_for<0, N>([&](auto i) {
+		static_for<0, N>([&](auto j) { factors[i][j] = system[i][j]; });
+	});
+	std::array<int, N> row_order{};
+	LU_factorize(factors, row_order);
+	static_for<0, N>([&](auto i) { b(i) = system[row_order[i]][N]; });
+	return back_substitution(factors, unit_forward_substitution(factors, b));
+}
+
+// Unblocked LU decomposition with partial pivoting in place, same layout of the factors and row_order as LU_factorize for Matrix<T>
+// The pivot row is found at run time, so rows are switched element by element
+template<Numerical T, int N>
+constexpr void LinSolver::LU_factorize(FixedMatrix<T, N, N>& input, std::type_identity_t<std::array<int, N>>& row_order)
+{
+	static_for<0, N>([&](auto i) { row_order[i] = i; });
+	static_for<0, N>([&](auto i) {
+		int max_row = i;
+		auto max_value = pivot_key(input[i][i]);
+		static_for<i + 1, N>([&](auto j) {
+			auto value = pivot_key(input[j][i]);
+			if (max_value < value) {
+				max_value = value;
+				max_row = j;
+			}
+		});
+		if (max_row != i) {
+			static_for<0, N>([&](auto k) { std::swap(input[i][k], input[max_row][k]); });
+			std::swap(row_order[i], row_order[max_row]);
+		}
+		static_for<i + 1, N>([&](auto j) {
+			input[j][i] = input[j][i] / input[i][i];
+			static_for<i + 1, N>([&](auto k) { input[j][k] = input[j][k] - input[j][i] * input[i][k]; });
+		});
+	});
+}
+
+// Solves triangle * X = B for all columns of B at once, x holds B on input and is overwritten by X
+// Only the lower (or upper) triangle of the matrix is read, with unit_diagonal the diagonal is assumed to be made of ones
+// Blas::trsm without transpose and scaling: the contribution of already solved blocks of rows is subtracted by one Gemm product,
+// the rest is solved by substitution within the block
+template<Numerical T>
+void LinSolver::solve_triangular(const MatrixView<const T>& triangle, const MatrixView<T>& x, const bool lower, const bool unit_diagonal, const int block_size)
+{
+	Blas::trsm<T>(lower, false, unit_diagonal, T(1), triangle, x, block_size);
+}
+
 // Returns the permutation vector of size n
 // Used in LU decomposition to store the row switches
 // Used only when calculating LU decomposition outside the solve_lu function, the permutation vector is given instead of the b vector to the decomposition function
@@ -184,62 +762,662 @@ Matrix<T> LinSolver::permuation_vector_to_matrix(const Matrix<T>& p_vector)
 	return p_matrix;
 }
 
+// Computes Q and R explicitly from the compact form of QR_factorize
 template<Numerical_WithSqrt T>
 void LinSolver::QR_decompose(const Matrix<T>& input, Matrix<T>& q, Matrix<T>& r)
+{
+	std::vector<T> tau;
+	r.copy_from(input);
+	QR_factorize(r, tau);
+	q = QR_form_q(r, tau);
+
+	for (int i = 1; i < r.get_row_count(); i++)
+		for (int j = 0; j < i; j++)
+			r[i][j] = 0;
+}
+
+// Householder QR decomposition done in place
+// Reflector i is H_i = I - tau[i] * v * v^H, where v has 1 on position i, the rest of v is stored below the diagonal in column i
+// (v^H is the conjugate transposition, for real types the transposition), tau[i] is real and H_i is hermitian and unitary
+// R is stored on and above the diagonal, Q = H_0 * H_1 * ... * H_(n-1)
+// Blocked algorithm: the reflectors of a panel of block_size columns are computed by householder_panel,
+// then they are accumulated into the compact WY form H_p * ... * H_(p+block_size-1) = I - V * T * V^H
+// and applied to the trailing columns at once as A2 = A2 - V * (T^H * (V^H * A2)), all three products computed by the parallel Gemm
+// Matrices with at most 2 * block_size rows are factorized by the unblocked algorithm
+template<Numerical_WithSqrt T>
+void LinSolver::QR_factorize(Matrix<T>& input, std::vector<T>& tau, const int block_size)
 {
 	if (!input.is_square())
 		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
 
 	int num_rows = input.get_row_count();
+	tau.assign(num_rows, T(0));
+	if (block_size < 1 || num_rows <= 2 * block_size) {
+		householder_panel(input, tau, 0, num_rows);
+		return;
+	}
 
-	q = Matrix<T>::identity(num_rows);
-	r.copy_from(input);
+	for (int panel = 0; panel < num_rows; panel += block_size) {
+		int width = std::min(block_size, num_rows - panel);
+		int panel_end = panel + width;
+		householder_panel(input, tau, panel, panel_end);
 
-	for (int i = 0; i < num_rows; i++)
+		int trailing = num_rows - panel_end;
+		if (trailing == 0)
+			break;
+		apply_block_reflector<T>(input.get_view(), tau, panel, width, input.get_submatrix(panel, panel_end, num_rows - panel, trailing), true);
+	}
+}
+
+// Unblocked Householder QR of the columns [first_column, end_column), the reflectors are applied only to these columns
+// The reflectors are generated as by LAPACK xLARFG, each is applied to the remaining columns as a rank-1 update, no n x n reflection matrices are formed
+template<Numerical_WithSqrt T>
+void LinSolver::householder_panel(Matrix<T>& input, std::vector<T>& tau, const int first_column, const int end_column)
+{
+	int num_rows = input.get_row_count();
+	std::vector<T> x, work;
+
+	for (int i = first_column; i < end_column; i++)
 	{
-		std::vector<T> x;
-		for (int j = i; j < num_rows; j++)
-			x.push_back(r.get_value(j, i));
+		x = input.get_submatrix(i, i, num_rows - i, 1).get_column(0).to_vector();
 
-		T norm = vector_norm(x);
-		if (x[0] - norm == 0) break;
-		x[0] = x[0] - norm;
+		T head = x[0];
+		T tail = 0;
+		for (size_t k = 1; k < x.size(); k++)
+			tail = tail + conjugate(x[k]) * x[k];
+		// the column is already reduced, its reflector is the identity (tau = 0)
+		if (tail == 0) continue;
 
-		auto H_x = householder_reflection(x);
-		auto H = Matrix<T>::identity(num_rows);
-		for (int j = i; j < num_rows; j++)
-			for (int k = i; k < num_rows; k++)
-				H[j][k] = H_x[j - i][k - i];
+		// x is mapped to beta * e_1, beta has the opposite sign (phase) of x_0, so x_0 - beta does not cancel
+		T magnitude = sqrt(conjugate(head) * head);
+		T norm = sqrt(conjugate(head) * head + tail);
+		T beta = magnitude == 0 ? -norm : -(head / magnitude) * norm;
 
-		r = H * r;
-		q = q * H;
+		// v is scaled so that its first element is 1, tau = (beta - x_0) / beta is the real 1 + |x_0| / norm
+		head = head - beta;
+		for (size_t k = 1; k < x.size(); k++)
+			x[k] = x[k] / head;
+		tau[i] = T(1) + magnitude / norm;
+
+		input[i][i] = beta;
+		for (int k = i + 1; k < num_rows; k++)
+			input[k][i] = x[k - i];
+
+		if (i + 1 < end_column)
+			apply_householder<T>(input.get_view(), tau[i], i, input.get_submatrix(0, i + 1, num_rows, end_column - i - 1), work);
 	}
 }
 
+// Computes the upper triangular T of the compact WY form I - V * T * V^H of the reflectors stored in the columns of v
+// Built column by column: T[i][i] = tau_i, T[0:i, i] = -tau_i * T[0:i, 0:i] * (V[:, 0:i]^H * v_i)
+template<Numerical_WithSqrt T>
+Matrix<T> LinSolver::householder_block_triangle(const Matrix<T>& v, const std::vector<T>& tau, const int first_column)
+{
+	int height = v.get_row_count();
+	int width = v.get_column_count();
+	Matrix<T> t(width, width);
+	std::vector<T> z(width);
+
+	for (int i = 0; i < width; i++) {
+		T tau_i = tau[first_column + i];
+		t[i][i] = tau_i;
+		// v_i is zero above row i
+		for (int j = 0; j < i; j++) {
+			T sum = 0;
+			for (int r = i; r < height; r++)
+				sum = sum + conjugate(v[r][j]) * v[r][i];
+			z[j] = sum;
+		}
+		for (int a = 0; a < i; a++) {
+			T sum = 0;
+			for (int b = a; b < i; b++)
+				sum = sum + t[a][b] * z[b];
+			t[a][i] = -tau_i * sum;
+		}
+	}
+	return t;
+}
+
+// Overwrites b by Q^H * b (Q^T * b for real types), using the reflectors stored by QR_factorize
+// With more than 2 * block_size rows the reflectors are applied in blocks in the compact WY form
+template<Numerical_WithSqrt T>
+void LinSolver::QR_apply_qt(const Matrix<T>& factors, const std::vector<T>& tau, const MatrixView<T>& b, const int block_size)
+{
+	int num_rows = factors.get_row_count();
+	if (b.get_row_count() != num_rows)
+		throw SystemSolverException("Error: cannot apply Q, incompatible dimensions");
+
+	if (block_size < 1 || num_rows <= 2 * block_size) {
+		std::vector<T> work;
+		for (int i = 0; i < num_rows; i++)
+			apply_householder<T>(factors.get_view(), tau[i], i, b, work);
+		return;
+	}
+	for (int panel = 0; panel < num_rows; panel += block_size) {
+		int width = std::min(block_size, num_rows - panel);
+		apply_block_reflector<T>(factors.get_view(), tau, panel, width, b.get_submatrix(panel, 0, num_rows - panel, b.get_column_count()), true);
+	}
+}
+
+// Forms the Q matrix from the reflectors stored by QR_factorize
+// The reflectors are applied to the identity from the last one, so H_i only changes the bottom right part from row and column i
+template<Numerical_WithSqrt T>
+Matrix<T> LinSolver::QR_form_q(const Matrix<T>& factors, const std::vector<T>& tau, const int block_size)
+{
+	int num_rows = factors.get_row_count();
+	Matrix<T> q = Matrix<T>::identity(num_rows);
+
+	if (block_size < 1 || num_rows <= 2 * block_size) {
+		std::vector<T> work;
+		for (int i = num_rows - 1; i >= 0; i--)
+			apply_householder<T>(factors.get_view(), tau[i], i, q.get_submatrix(0, i, num_rows, num_rows - i), work);
+		return q;
+	}
+	int last_panel = (num_rows - 1) / block_size * block_size;
+	for (int panel = last_panel; panel >= 0; panel -= block_size) {
+		int width = std::min(block_size, num_rows - panel);
+		apply_block_reflector<T>(factors.get_view(), tau, panel, width, q.get_submatrix(panel, panel, num_rows - panel, num_rows - panel), false);
+	}
+	return q;
+}
+
+template<Numerical_WithSqrt T>
+Matrix<T> LinSolver::solve_cholesky(const Matrix<T>& system, const int block_size)
+{
+	MatrixView<const T> left_view, b_view;
+	divide_system(system, left_view, b_view);
+	Matrix<T> left(left_view), b(b_view);
+	cholesky_factorize(left, block_size);
+	cholesky_solve(left, b.get_view());
+	return b;
+}
+
+template<Numerical_WithSqrt T>
+Matrix<T> LinSolver::solve_cholesky(PackedSymmetricMatrix<T>& matrix, const Matrix<T>& b, const int block_size)
+{
+	if (b.get_row_count() != matrix.get_size())
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	cholesky_factorize(matrix, block_size);
+	Matrix<T> x(b);
+	cholesky_solve(matrix, x.get_view());
+	return x;
+}
+
+template<Numerical_WithSqrt T>
+Matrix<T> LinSolver::solve_ldlt(const Matrix<T>& system)
+{
+	MatrixView<const T> left_view, b_view;
+	divide_system(system, left_view, b_view);
+	Matrix<T> left(left_view), b(b_view);
+	std::vector<int> row_order, pivot_sizes;
+	ldlt_factorize(left, row_order, pivot_sizes);
+	ldlt_solve(left, row_order, pivot_sizes, b.get_view());
+	return b;
+}
+
+// Blocked right-looking Cholesky factorization A = L * L^T, only the lower triangle of the input is read
+// For every block column: the diagonal block and the panel below it are factorized row by row (the panel rows in parallel),
+// then the lower part of the trailing matrix is updated by A22 = A22 - L21 * L21^T, one Gemm per block row, so only half of the products is computed
+// Complex matrices are factorized in the bilinear form (complex symmetric, not hermitian), like the reflectors of QR
+template<Numerical_WithSqrt T>
+void LinSolver::cholesky_factorize(Matrix<T>& input, const int block_size)
+{
+	if (!input.is_square())
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+	int size = input.get_row_count();
+	int block = block_size < 1 ? size : block_size;
+	auto row = [&](int i) { return input[i]; };
+	ThreadPool& pool = ThreadPool::instance();
+
+	for (int first = 0; first < size; first += block) {
+		int end = std::min(first + block, size);
+		for (int i = first; i < end; i++)
+			cholesky_row<T>(row, i, first, i + 1, first);
+		pool.parallel_for(end, size, [&](int i) { cholesky_row<T>(row, i, first, end, first); });
+
+		int trailing_blocks = (size - end + block - 1) / block;
+		pool.parallel_for(0, trailing_blocks, [&](int b) {
+			int block_first = end + b * block;
+			int block_end = std::min(block_first + block, size);
+			Gemm::multiply<T>(input.get_submatrix(block_first, first, block_end - block_first, end - first), false,
+				input.get_submatrix(end, first, block_end - end, end - first), true,
+				input.get_view().get_submatrix(block_first, end, block_end - block_first, block_end - end), T(-1), T(1));
+		});
+	}
+
+	// the trailing updates also wrote above the diagonal of the diagonal blocks, the result holds only L
+	for (int i = 0; i < size; i++)
+		std::fill(input[i] + i + 1, input[i] + size, T(0));
+}
+
+// Cholesky factorization of the packed lower triangle, overwritten by L
+// Rows are processed in blocks: the part of the block left of it depends only on finished rows, so those rows are computed in parallel
+// (every finished row is read once for a group of rows), the small triangle of the block itself is computed sequentially
+template<Numerical_WithSqrt T>
+void LinSolver::cholesky_factorize(PackedSymmetricMatrix<T>& input, const int block_size)
+{
+	int size = input.get_size();
+	int block = block_size < 1 ? size : block_size;
+	const int group = 4;
+	auto row = [&](int i) { return input.row(i); };
+
+	for (int first = 0; first < size; first += block) {
+		int end = std::min(first + block, size);
+		ThreadPool::instance().parallel_for(0, (end - first + group - 1) / group, [&](int g) {
+			int group_first = first + g * group;
+			int group_end = std::min(group_first + group, end);
+			for (int j = 0; j < first; j++) {
+				const T* row_j = input.row(j);
+				for (int i = group_first; i < group_end; i++) {
+					T* row_i = input.row(i);
+					row_i[j] = (row_i[j] - VectorKernels<T>::dot(j, row_i, row_j)) / row_j[j];
+				}
+			}
+		});
+		for (int i = first; i < end; i++)
+			cholesky_row<T>(row, i, first, i + 1, 0);
+	}
+}
+
+// Elements [first_column, end_column) of row i of L, the products of columns [dot_start, j) are subtracted
+// (columns before dot_start were already subtracted by the trailing updates), the diagonal element is the square root of the pivot
+template<Numerical_WithSqrt T, typename RowAccess>
+void LinSolver::cholesky_row(const RowAccess& row, const int i, const int first_column, const int end_column, const int dot_start)
+{
+	T* row_i = row(i);
+	for (int j = first_column; j < end_column; j++) {
+		const T* row_j = row(j);
+		T value = row_i[j] - VectorKernels<T>::dot(j - dot_start, row_i + dot_start, row_j + dot_start);
+		if (j < i) {
+			row_i[j] = value / row_j[j];
+			continue;
+		}
+		// complex numbers are compared by absolute value, so only zero pivots are rejected for them
+		if (value == 0 || value < T(0))
+			throw SystemSolverException("Error: cannot compute Cholesky decomposition, matrix is not positive definite");
+		row_i[j] = sqrt(value);
+	}
+}
+
+template<Numerical T>
+void LinSolver::cholesky_solve(const Matrix<T>& factor, const MatrixView<T>& b)
+{
+	if (b.get_row_count() != factor.get_row_count())
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	solve_triangular<T>(factor.get_view(), b, true, false);
+	lower_transposed_substitution<T>([&](int i) { return factor[i]; }, factor.get_row_count(), b, false);
+}
+
+template<Numerical T>
+void LinSolver::cholesky_solve(const PackedSymmetricMatrix<T>& factor, const MatrixView<T>& b)
+{
+	if (b.get_row_count() != factor.get_size())
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	auto row = [&](int i) { return factor.row(i); };
+	lower_substitution<T>(row, factor.get_size(), b, false);
+	lower_transposed_substitution<T>(row, factor.get_size(), b, false);
+}
+
+// Solves L * X = B in place, row i of L is the contiguous array row(i) of i + 1 elements
+template<Numerical T, typename RowAccess>
+void LinSolver::lower_substitution(const RowAccess& row, const int size, const MatrixView<T>& b, const bool unit_diagonal)
+{
+	int column_count = b.get_column_count();
+	bool contiguous = column_count == 1 && b.get_leading_dimension() == 1;
+	for (int i = 0; i < size; i++) {
+		const T* row_i = row(i);
+		if (contiguous)
+			b(i) = b(i) - VectorKernels<T>::dot(i, row_i, b.data());
+		else
+			for (int j = 0; j < i; j++)
+				VectorKernels<T>::axpy(column_count, -row_i[j], b[j], b[i]);
+		if (!unit_diagonal)
+			for (int k = 0; k < column_count; k++)
+				b[i][k] = b[i][k] / row_i[i];
+	}
+}
+
+// Solves L^T * X = B in place going from the last row up, every solved row of X is subtracted with the row of L as coefficients
+template<Numerical T, typename RowAccess>
+void LinSolver::lower_transposed_substitution(const RowAccess& row, const int size, const MatrixView<T>& b, const bool unit_diagonal)
+{
+	int column_count = b.get_column_count();
+	bool contiguous = column_count == 1 && b.get_leading_dimension() == 1;
+	for (int i = size - 1; i >= 0; i--) {
+		const T* row_i = row(i);
+		if (!unit_diagonal)
+			for (int k = 0; k < column_count; k++)
+				b[i][k] = b[i][k] / row_i[i];
+		if (contiguous)
+			VectorKernels<T>::axpy(i, -b(i), row_i, b.data());
+		else
+			for (int j = 0; j < i; j++)
+				VectorKernels<T>::axpy(column_count, -row_i[j], b[i], b[j]);
+	}
+}
+
+// LDL^T factorization with Bunch-Kaufman pivoting, P * A * P^T = L * D * L^T for symmetric, possibly indefinite matrices
+// D is block diagonal with 1x1 and 2x2 blocks, a 2x2 block is used when no diagonal element is large enough compared to its column
+// Only the lower triangle is read and updated; pivot choices depend on the updated column, so the trailing update is done
+// after every pivot, split by rows over the ThreadPool
+// Result: the strict lower triangle holds L (unit diagonal not stored), the diagonal holds the diagonal of D and the off-diagonal element of
+// a 2x2 block at rows k, k + 1 is stored above the diagonal at (k, k + 1); pivot_sizes[k] is 1 or 2 for every row of a block
+template<Numerical_WithSqrt T>
+void LinSolver::ldlt_factorize(Matrix<T>& input, std::vector<int>& row_order, std::vector<int>& pivot_sizes)
+{
+	if (!input.is_square())
+		throw SystemSolverException("Error: invalid linear equation system format, input matrix is not square");
+	int size = input.get_row_count();
+	row_order.resize(size);
+	std::iota(row_order.begin(), row_order.end(), 0);
+	pivot_sizes.assign(size, 1);
+	for (int i = 0; i < size; i++)
+		std::fill(input[i] + i + 1, input[i] + size, T(0));
+
+	const double alpha = (1 + std::sqrt(17.0)) / 8;
+	std::vector<T> first_multipliers(size), second_multipliers(size);
+	const int rows_per_task = 64;
+	ThreadPool& pool = ThreadPool::instance();
+
+	int k = 0;
+	while (k < size) {
+		double diagonal_max = pivot_magnitude(input[k][k]);
+		int max_row = k;
+		double column_max = 0;
+		for (int i = k + 1; i < size; i++)
+			if (pivot_magnitude(input[i][k]) > column_max) {
+				column_max = pivot_magnitude(input[i][k]);
+				max_row = i;
+			}
+		if (diagonal_max == 0 && column_max == 0)
+			throw SystemSolverException("Error: cannot compute LDL^T decomposition, matrix is singular");
+
+		int pivot = k, step = 1;
+		if (diagonal_max < alpha * column_max) {
+			// largest element of row max_row of the trailing matrix outside the diagonal
+			double row_max = 0;
+			for (int j = k; j < max_row; j++)
+				row_max = std::max(row_max, pivot_magnitude(input[max_row][j]));
+			for (int i = max_row + 1; i < size; i++)
+				row_max = std::max(row_max, pivot_magnitude(input[i][max_row]));
+
+			if (diagonal_max * row_max >= alpha * column_max * column_max)
+				pivot = k;
+			else if (pivot_magnitude(input[max_row][max_row]) >= alpha * row_max)
+				pivot = max_row;
+			else {
+				pivot = max_row;
+				step = 2;
+			}
+		}
+		int target = k + step - 1;
+		if (pivot != target) {
+			symmetric_swap(input, target, pivot);
+			std::swap(row_order[target], row_order[pivot]);
+		}
+
+		int rest = k + step;
+		int task_count = (size - rest + rows_per_task - 1) / rows_per_task;
+		if (step == 1) {
+			T d = input[k][k];
+			for (int j = rest; j < size; j++)
+				first_multipliers[j] = input[j][k] / d;
+			// A(i, j) = A(i, j) - A(i, k) * l(j, k) for rest <= j <= i
+			pool.parallel_for(0, task_count, [&](int task) {
+				int end = std::min(rest + (task + 1) * rows_per_task, size);
+				for (int i = rest + task * rows_per_task; i < end; i++) {
+					VectorKernels<T>::axpy(i - rest + 1, -input[i][k], first_multipliers.data() + rest, input[i] + rest);
+					input[i][k] = first_multipliers[i];
+				}
+			});
+		}
+		else {
+			T d11 = input[k][k], d21 = input[k + 1][k], d22 = input[k + 1][k + 1];
+			T determinant = d11 * d22 - d21 * d21;
+			if (determinant == 0)
+				throw SystemSolverException("Error: cannot compute LDL^T decomposition, matrix is singular");
+			// [l(j, k), l(j, k + 1)] = [A(j, k), A(j, k + 1)] * D^-1
+			for (int j = rest; j < size; j++) {
+				first_multipliers[j] = (input[j][k] * d22 - input[j][k + 1] * d21) / determinant;
+				second_multipliers[j] = (input[j][k + 1] * d11 - input[j][k] * d21) / determinant;
+			}
+			pool.parallel_for(0, task_count, [&](int task) {
+				int end = std::min(rest + (task + 1) * rows_per_task, size);
+				for (int i = rest + task * rows_per_task; i < end; i++) {
+					VectorKernels<T>::axpy(i - rest + 1, -input[i][k], first_multipliers.data() + rest, input[i] + rest);
+					VectorKernels<T>::axpy(i - rest + 1, -input[i][k + 1], second_multipliers.data() + rest, input[i] + rest);
+					input[i][k] = first_multipliers[i];
+					input[i][k + 1] = second_multipliers[i];
+				}
+			});
+			input[k][k + 1] = d21;
+			input[k + 1][k] = 0;
+			pivot_sizes[k] = pivot_sizes[k + 1] = 2;
+		}
+		k += step;
+	}
+}
+
+// Solves A * X = B from the LDL^T factors: X = P^T * L^-T * D^-1 * L^-1 * P * B
+template<Numerical T>
+void LinSolver::ldlt_solve(const Matrix<T>& factors, const std::vector<int>& row_order, const std::vector<int>& pivot_sizes, const MatrixView<T>& b)
+{
+	int size = factors.get_row_count();
+	if (b.get_row_count() != size)
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	int column_count = b.get_column_count();
+	Matrix<T> y(size, column_count);
+	for (int i = 0; i < size; i++)
+		y.get_row(i).copy_from(b.get_row(row_order[i]));
+
+	solve_triangular<T>(factors.get_view(), y.get_view(), true, true);
+	for (int k = 0; k < size; k += pivot_sizes[k]) {
+		if (pivot_sizes[k] == 1) {
+			for (int c = 0; c < column_count; c++)
+				y[k][c] = y[k][c] / factors[k][k];
+			continue;
+		}
+		T d11 = factors[k][k], d21 = factors[k][k + 1], d22 = factors[k + 1][k + 1];
+		T determinant = d11 * d22 - d21 * d21;
+		for (int c = 0; c < column_count; c++) {
+			T first = y[k][c], second = y[k + 1][c];
+			y[k][c] = (d22 * first - d21 * second) / determinant;
+			y[k + 1][c] = (d11 * second - d21 * first) / determinant;
+		}
+	}
+	lower_transposed_substitution<T>([&](int i) { return factors[i]; }, size, y.get_view(), true);
+
+	for (int i = 0; i < size; i++)
+		b.get_row(row_order[i]).copy_from(y.get_row(i));
+}
+
+// Swaps rows and columns p < q of a symmetric matrix stored in the lower triangle, including the already computed part of L left of p
+template<Numerical T>
+void LinSolver::symmetric_swap(Matrix<T>& input, const int p, const int q)
+{
+	int size = input.get_row_count();
+	for (int j = 0; j < p; j++)
+		std::swap(input[p][j], input[q][j]);
+	for (int j = p + 1; j < q; j++)
+		std::swap(input[j][p], input[q][j]);
+	std::swap(input[p][p], input[q][q]);
+	for (int i = q + 1; i < size; i++)
+		std::swap(input[i][p], input[i][q]);
+}
+
+template<Numerical T>
+double LinSolver::pivot_magnitude(const T& value)
+{
+	using std::abs;
+	return static_cast<double>(abs(value));
+}
+
+// Solves a banded system, tridiagonal diagonally dominant matrices use the Thomas algorithm (no pivoting needed),
+// other matrices (and tridiagonal ones on which Thomas meets a zero pivot) the banded LU with partial pivoting; the matrix is not modified
+template<Numerical T>
+Matrix<T> LinSolver::solve_banded(const BandedMatrix<T>& matrix, const Matrix<T>& b)
+{
+	if (b.get_row_count() != matrix.get_size())
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	Matrix<T> x(b);
+	if (matrix.is_tridiagonal() && is_diagonally_dominant(matrix)) {
+		int size = matrix.get_size();
+		int lower = matrix.get_lower_bandwidth();
+		std::vector<T> work(size);
+		bool solved = thomas_algorithm<T>(size,
+			[&](int i) { return lower == 1 ? matrix.band_row(i)[0] : T(0); },
+			[&](int i) { return matrix.band_row(i)[lower]; },
+			[&](int i) { return matrix.get_upper_bandwidth() == 1 ? matrix.band_row(i)[lower + 1] : T(0); },
+			x.get_view(), work);
+		if (solved)
+			return x;
+		x.copy_from(b);
+	}
+	BandedMatrix<T> factors(matrix);
+	std::vector<int> pivots;
+	banded_LU_factorize(factors, pivots);
+	banded_LU_solve(factors, pivots, x.get_view());
+	return x;
+}
+
+// sub[i] = A(i + 1, i) and super[i] = A(i, i + 1) have n - 1 elements, diagonal and b n elements
+template<Numerical T>
+std::vector<T> LinSolver::solve_tridiagonal(const std::vector<T>& sub, const std::vector<T>& diagonal, const std::vector<T>& super, const std::vector<T>& b)
+{
+	int size = static_cast<int>(diagonal.size());
+	if (static_cast<int>(b.size()) != size || static_cast<int>(sub.size()) != size - 1 || static_cast<int>(super.size()) != size - 1)
+		throw SystemSolverException("Error: cannot solve tridiagonal system, incompatible dimensions");
+	std::vector<T> x(b), work(size);
+	bool solved = thomas_algorithm<T>(size,
+		[&](int i) { return i > 0 ? sub[i - 1] : T(0); },
+		[&](int i) { return diagonal[i]; },
+		[&](int i) { return i < size - 1 ? super[i] : T(0); },
+		MatrixView<T>(x.data(), size, 1, 1), work);
+	if (!solved)
+		throw SystemSolverException("Error: cannot solve tridiagonal system, zero pivot");
+	return x;
+}
+
+// Thomas algorithm: Gaussian elimination of a tridiagonal matrix without pivoting, O(n) for every right side
+// sub(i) = A(i, i - 1), diagonal(i) = A(i, i), super(i) = A(i, i + 1); work holds the modified super diagonal
+// returns false when a zero pivot is met (the matrix needs pivoting or is singular), b is then partially overwritten
+template<Numerical T, typename Sub, typename Diagonal, typename Super>
+bool LinSolver::thomas_algorithm(const int size, const Sub& sub, const Diagonal& diagonal, const Super& super, const MatrixView<T>& b, std::vector<T>& work)
+{
+	int column_count = b.get_column_count();
+	for (int i = 0; i < size; i++) {
+		T pivot = i > 0 ? diagonal(i) - sub(i) * work[i - 1] : diagonal(i);
+		if (pivot == 0)
+			return false;
+		work[i] = super(i) / pivot;
+		for (int c = 0; c < column_count; c++)
+			b[i][c] = i > 0 ? (b[i][c] - sub(i) * b[i - 1][c]) / pivot : b[i][c] / pivot;
+	}
+	for (int i = size - 2; i >= 0; i--)
+		for (int c = 0; c < column_count; c++)
+			b[i][c] = b[i][c] - work[i] * b[i + 1][c];
+	return true;
+}
+
+// LU decomposition of a banded matrix with partial pivoting, P * A = L * U in O(n * lower * (lower + upper))
+// Row swaps move up to lower_bandwidth elements beyond the upper bandwidth, so the band is first widened to lower + upper above the diagonal
+// The factors replace the matrix: multipliers of L below the diagonal, U on and above it
+// pivots[k] is the row swapped with row k in step k (the rows of L are not swapped afterwards, banded_LU_solve applies the swaps in the same order)
+template<Numerical T>
+void LinSolver::banded_LU_factorize(BandedMatrix<T>& input, std::vector<int>& pivots)
+{
+	int size = input.get_size();
+	int lower = input.get_lower_bandwidth();
+	input.set_upper_bandwidth(input.get_upper_bandwidth() + lower);
+	int upper = input.get_upper_bandwidth();
+	pivots.resize(size);
+
+	// element (i, j) of the band is band_row(i)[j - i + lower]
+	for (int k = 0; k < size; k++) {
+		int last_row = std::min(size - 1, k + lower);
+		int pivot = k;
+		for (int i = k + 1; i <= last_row; i++)
+			if (abs(input.band_row(i)[k - i + lower]) > abs(input.band_row(pivot)[k - pivot + lower]))
+				pivot = i;
+		T pivot_value = input.band_row(pivot)[k - pivot + lower];
+		if (pivot_value == 0)
+			throw SystemSolverException("Error: cannot compute banded LU decomposition, matrix is singular");
+		pivots[k] = pivot;
+
+		int count = std::min(size - 1, k + upper) - k + 1;
+		if (pivot != k)
+			std::swap_ranges(input.band_row(k) + lower, input.band_row(k) + lower + count, input.band_row(pivot) + (k - pivot + lower));
+
+		const T* row_k = input.band_row(k) + lower;
+		for (int i = k + 1; i <= last_row; i++) {
+			T* row_i = input.band_row(i) + (k - i + lower);
+			row_i[0] = row_i[0] / row_k[0];
+			VectorKernels<T>::axpy(count - 1, -row_i[0], row_k + 1, row_i + 1);
+		}
+	}
+}
+
+template<Numerical T>
+void LinSolver::banded_LU_solve(const BandedMatrix<T>& factors, const std::vector<int>& pivots, const MatrixView<T>& b)
+{
+	int size = factors.get_size();
+	if (b.get_row_count() != size)
+		throw SystemSolverException("Error: cannot solve system, right side has incorrect number of rows");
+	int lower = factors.get_lower_bandwidth();
+	int upper = factors.get_upper_bandwidth();
+	int column_count = b.get_column_count();
+
+	for (int k = 0; k < size; k++) {
+		if (pivots[k] != k)
+			b.get_row(k).swap_with(b.get_row(pivots[k]));
+		for (int i = k + 1; i <= std::min(size - 1, k + lower); i++)
+			VectorKernels<T>::axpy(column_count, -factors.band_row(i)[k - i + lower], b[k], b[i]);
+	}
+	for (int i = size - 1; i >= 0; i--) {
+		const T* row_i = factors.band_row(i) + lower;
+		for (int j = i + 1; j <= std::min(size - 1, i + upper); j++)
+			VectorKernels<T>::axpy(column_count, -row_i[j - i], b[j], b[i]);
+		for (int c = 0; c < column_count; c++)
+			b[i][c] = b[i][c] / row_i[0];
+	}
+}
+
+// |A(i, i)| >= sum of |A(i, j)| over the other elements of the row, for every row
+template<Numerical T>
+bool LinSolver::is_diagonally_dominant(const BandedMatrix<T>& matrix)
+{
+	int size = matrix.get_size();
+	for (int i = 0; i < size; i++) {
+		T off_diagonal = 0;
+		for (int j = std::max(0, i - matrix.get_lower_bandwidth()); j <= std::min(size - 1, i + matrix.get_upper_bandwidth()); j++)
+			if (j != i)
+				off_diagonal = off_diagonal + abs(matrix.get_value(i, j));
+		if (abs(matrix.get_value(i, i)) < off_diagonal)
+			return false;
+	}
+	return true;
+}
+
 // Forward substitution - used in LU decomposition
+// x(i) is written after b(i) is read and only the solved x(0) ... x(i - 1) are read, so x can overwrite b
 template<Numerical T>
-Matrix<T> LinSolver::forward_substitution(const Matrix<T>& matrix, const Matrix<T>& b)
+void LinSolver::forward_substitution(const MatrixView<const T>& matrix, const MatrixView<const T>& b, const MatrixView<T>& x)
 {
 	int row_count = matrix.get_row_count();
-	Matrix<T> x(row_count, 1);
 	for(int i = 0; i < row_count; i++)
 	{
 		if(matrix[i][i] == 0)
 			throw SystemSolverException("Error: cannot compute forward substituion, zero on the matrixs diagonal");
-		T curr_sum = 0;
-		for (int j = 0; j < i; j++)
-			curr_sum = curr_sum + matrix[i][j] * x(j);
+		T curr_sum = Blas::dot(VectorView<const T>(matrix[i], i), VectorView<const T>(x.data(), i, x.get_leading_dimension()));
 		x(i) = (b(i) - curr_sum) / matrix[i][i];
 	}
-	return x;
 }
 
 // Backward substitution - used in LU decomposition, QR decomposition and Gauss-Seidel
 template<Numerical T>
-Matrix<T> LinSolver::back_substitution(const Matrix<T>& matrix, const Matrix<T>& b)
+void LinSolver::back_substitution(const MatrixView<const T>& matrix, const MatrixView<const T>& b, const MatrixView<T>& x)
 {
 	int row_count = matrix.get_row_count();
-	Matrix<T> x(row_count, 1);
 	for (int i = row_count - 1; i >= 0; i--)
 	{
 		if (matrix[i][i] == 0)
@@ -247,51 +1425,124 @@ Matrix<T> LinSolver::back_substitution(const Matrix<T>& matrix, const Matrix<T>&
 				throw SystemSolverException("Error: cannot compute back substituion, infinitely many solutions or unable to find solution") :
 				throw SystemSolverException("Error: cannot compute back substituion, no solution or unable to find solution");
 
-		T curr_sum = 0;
-		for (int j = i+1; j < row_count; j++)
-			curr_sum = curr_sum + matrix[i][j] * x(j);
+		// the last row has no solved elements after it, x(i + 1) would be past the end of the view
+		T curr_sum = i + 1 < row_count ?
+			Blas::dot(VectorView<const T>(matrix[i] + i + 1, row_count - i - 1), VectorView<const T>(&x(i + 1), row_count - i - 1, x.get_leading_dimension())) :
+			T(0);
 		x(i) = (b(i) - curr_sum) / matrix[i][i];
 	}
+}
+
+template<Numerical T, int N>
+constexpr FixedMatrix<T, N, 1> LinSolver::back_substitution(const FixedMatrix<T, N, N + 1>& system)
+{
+	FixedMatrix<T, N, N> matrix;
+	FixedMatrix<T, N, 1> b;
+	static_for<0, N>([&](auto i) {
+		static_for<i, N>([&](auto j) { matrix[i][j] = system[i][j]; });
+		b(i) = system[i][N];
+	});
+	return back_substitution(matrix, b);
+}
+
+template<Numerical T, int N>
+constexpr FixedMatrix<T, N, 1> LinSolver::back_substitution(const FixedMatrix<T, N, N>& matrix, const FixedMatrix<T, N, 1>& b)
+{
+	FixedMatrix<T, N, 1> x;
+	static_for<0, N>([&](auto step) {
+		constexpr int i = N - 1 - decltype(step)::value;
+		T diagonal = matrix[i][i];
+		if (diagonal == 0) {
+			T right_side = b(i);
+			right_side == 0 ?
+				throw SystemSolverException("Error: cannot compute back substituion, infinitely many solutions or unable to find solution") :
+				throw SystemSolverException("Error: cannot compute back substituion, no solution or unable to find solution");
+		}
+		T sum = b(i);
+		static_for<i + 1, N>([&](auto j) { sum = sum - matrix[i][j] * x(j); });
+		x(i) = sum / diagonal;
+	});
+	return x;
+}
+
+template<Numerical T, int N>
+constexpr FixedMatrix<T, N, 1> LinSolver::unit_forward_substitution(const FixedMatrix<T, N, N>& matrix, const FixedMatrix<T, N, 1>& b)
+{
+	FixedMatrix<T, N, 1> x;
+	static_for<0, N>([&](auto i) {
+		T sum = b(i);
+		static_for<0, i>([&](auto j) { sum = sum - matrix[i][j] * x(j); });
+		x(i) = sum;
+	});
 	return x;
 }
 
-// Divides the input matrix into two matrices, the left matrix is the matrix without the last column and the right matrix is the last column ([A|b] -> A, b)
 template<Numerical T>
-void LinSolver::divide_system(const Matrix<T>& input, Matrix<T>& left, Matrix<T>& right)
+constexpr auto LinSolver::pivot_key(const T& value)
+{
+	if constexpr (std::is_arithmetic_v<T>)
+		return value < 0 ? -value : value;
+	else if constexpr (is_floating_complex<T>::value)
+		return std::norm(value);
+	else
+		return abs(value);
+}
+
+template<Numerical T>
+T LinSolver::conjugate(const T& value)
+{
+	if constexpr (is_floating_complex<T>::value)
+		return std::conj(value);
+	else
+		return value;
+}
+
+// Reorders the rows of the input so that row i is the original row row_order[i]
+template<Numerical T>
+void LinSolver::permute_rows(Matrix<T>& input, const std::vector<int>& row_order)
+{
+	Matrix<T> original(input);
+	for (int i = 0; i < input.get_row_count(); i++)
+		input.get_row(i).copy_from(original.get_row(row_order[i]));
+}
+
+// Divides the input matrix into two views, the left view is the matrix without the last column and the right view is the last column ([A|b] -> A, b)
+// Nothing is copied, algorithms that modify the system make their own copy of the views
+template<Numerical T>
+void LinSolver::divide_system(const Matrix<T>& input, MatrixView<const T>& left, MatrixView<const T>& right)
 {
 	int row_count = input.get_row_count();
 	int column_count = input.get_column_count();
-	left.resize(row_count, column_count - 1);
-	right.resize(row_count, 1);
-	for (int i = 0; i < row_count; i++)
-	{
-		left[i].assign(input[i].cbegin(), input[i].cend() - 1);
-		right[i][0] = input[i][column_count - 1];
-	}
+	if (column_count < 1)
+		throw SystemSolverException("Error: invalid linear equation system format, missing right side column");
+	left = input.get_submatrix(0, 0, row_count, column_count - 1);
+	right = input.get_submatrix(0, column_count - 1, row_count, 1);
 }
 
-// Returns the index of the row with the biggest absolute value in the given column
+// Returns the index of the row with the biggest absolute value in the given column, only rows from column_idx down are searched
 // Used for partial pivotation in LU decomposition
 template<Numerical T>
-int LinSolver::get_row_to_switch(Matrix<T>& input, const int column_idx)
+int LinSolver::get_row_to_switch(const MatrixView<const T>& input, const int column_idx)
 {
 	int num_rows = input.get_row_count();
-	T max_value = input[0][column_idx];
+	auto max_value = pivot_key(input[column_idx][column_idx]);
 	int max_row = column_idx;
-	for (int row_idx = column_idx + 1; row_idx < num_rows; row_idx++)
-		if (max_value < abs(input[row_idx][column_idx])) {
-			max_value = abs(input[row_idx][column_idx]);
+	for (int row_idx = column_idx + 1; row_idx < num_rows; row_idx++) {
+		auto value = pivot_key(input[row_idx][column_idx]);
+		if (max_value < value) {
+			max_value = value;
 			max_row = row_idx;
 		}
+	}
 	return max_row;
 }
 
 template<Numerical T>
 void LinSolver::switch_rows(Matrix<T>& input, const int idx1, const int idx2)
 {
-	auto temp = input.get_row(idx1);
-	input.set_row(idx1, input.get_row(idx2));
-	input.set_row(idx2, temp);
+	if (idx1 == idx2)
+		return;
+	input.get_row(idx1).swap_with(input.get_row(idx2));
 }
 
 // Splits the input matrix into two matrices, the left matrix is the lower triangular matrix and the right matrix is the upper triangular matrix
@@ -299,38 +1550,27 @@ template<Numerical T>
 void LinSolver::split_lu(const Matrix<T>& input, Matrix<T>& lower, Matrix<T>& upper)
 {
 	int row_count = input.get_row_count();
-	lower.resize(row_count, row_count);
-	upper.resize(row_count, row_count);
+	lower = Matrix<T>(row_count, row_count);
+	upper = Matrix<T>(row_count, row_count);
 
+	// row by row, so that both the input and the outputs are read and written contiguously
 	for (int i = 0; i < row_count; i++)
 	{
-		lower[i][i] = 1;
-		upper[i][i] = input[i][i];
-		for (int j = i+1; j < row_count; j++)
-		{
-			lower[j][i] = input[j][i];
-			upper[i][j] = input[i][j];
-		}
+		const T* input_row = input[i];
+		T* lower_row = lower[i];
+		T* upper_row = upper[i];
+		for (int j = 0; j < i; j++)
+			lower_row[j] = input_row[j];
+		lower_row[i] = 1;
+		for (int j = i; j < row_count; j++)
+			upper_row[j] = input_row[j];
 	}
 }
 
-// Checks if current and previous iteration of Gauss-Seidel method are close enough to each other
-template<Numerical T>
-bool LinSolver::gs_check_accuracy(const Matrix<T>& old_x, const Matrix<T>& new_x, const T accuracy)
-{
-	for (int i = 0; i < old_x.get_row_count(); i++)
-		if (abs(old_x(i) - new_x(i)) > accuracy)
-			return false;
-	return true;
-}
-
 template<Numerical_WithSqrt T>
 T LinSolver::dot_product(const std::vector<T>& x, const std::vector<T>& y)
 {
-	T dot = 0;
-	for (size_t i = 0; i < x.size(); i++)
-		dot = dot + x[i] * y[i];
-	return dot;
+	return VectorKernels<T>::dot(static_cast<int>(x.size()), x.data(), y.data());
 }
 
 template<Numerical_WithSqrt T>
@@ -339,25 +1579,57 @@ T LinSolver::vector_norm(const std::vector<T>& x)
 	return sqrt(dot_product(x,x));
 }
 
-// Returns the householder matrix for the given vector
-// Used in QR decomposition
+// Applies the block of reflectors stored in columns [first_column, first_column + width) of the factors to the target,
+// whose first row corresponds to row first_column of the factors
+// The block is used in the compact WY form: H_first * ... * H_last = I - V * T * V^H, with transpose its conjugate transposition I - V * T^H * V^H is applied
+// target = target - V * (op(T) * (V^H * target)), all three products computed by the parallel Gemm
 template<Numerical_WithSqrt T>
-Matrix<T> LinSolver::householder_reflection(const std::vector<T>& x)
+void LinSolver::apply_block_reflector(const MatrixView<const T>& factors, const std::vector<T>& tau, const int first_column, const int width, const MatrixView<T>& target, const bool transpose)
 {
-	Matrix<T> householder = Matrix<T>::identity(x.size());
+	// V is unit lower trapezoidal, copied out of the factors so that it can be used by Gemm directly
+	int height = target.get_row_count();
+	int target_width = target.get_column_count();
+	Matrix<T> v(height, width);
+	for (int i = 0; i < height; i++)
+		for (int j = 0; j <= i && j < width; j++)
+			v[i][j] = i == j ? T(1) : factors[first_column + i][first_column + j];
+	Matrix<T> t = householder_block_triangle(v, tau, first_column);
+
+	Matrix<T> w(width, target_width), tw(width, target_width);
+	if constexpr (is_floating_complex<T>::value) {
+		// Gemm does not conjugate, V^H and T^H are computed as transpositions of the conjugated V and T
+		Matrix<T> v_conjugate(height, width);
+		for (int i = 0; i < height; i++)
+			for (int j = 0; j < width; j++)
+				v_conjugate[i][j] = conjugate(v[i][j]);
+		Gemm::multiply<T>(v_conjugate.get_view(), true, target, false, w.get_view());
+		if (transpose)
+			for (int i = 0; i < width; i++)
+				for (int j = i; j < width; j++)
+					t[i][j] = conjugate(t[i][j]);
+	}
+	else
+		Gemm::multiply<T>(v.get_view(), true, target, false, w.get_view());
+	Gemm::multiply<T>(t.get_view(), transpose, w.get_view(), false, tw.get_view());
+	Gemm::multiply<T>(v.get_view(), false, tw.get_view(), false, target, T(-1), T(1));
+}
 
-	Matrix<T> x_matrix = Matrix<T>(x.size(), 1);
-	for (size_t i = 0; i < x.size(); i++)
-		x_matrix[i][0] = x[i];
+// Applies the reflector I - tau * v * v^H stored in the given column of the factors to rows [column, n) of the target
+// Computed as a rank-1 update: w = v^H * target, target = target - tau * v * w, both done row by row
+template<Numerical_WithSqrt T>
+void LinSolver::apply_householder(const MatrixView<const T>& factors, const T tau, const int column, const MatrixView<T>& target, std::vector<T>& work)
+{
+	if (tau == 0)
+		return;
+	int num_rows = target.get_row_count();
+	int width = target.get_column_count();
 
-	Matrix<T> outer_product = x_matrix * x_matrix.transpose();
-	T factor = T(2) / dot_product(x, x);
-	for (size_t i = 0; i < x.size(); i++)
-		for (size_t j = 0; j < x.size(); j++)
-		{
-			outer_product[i][j] = outer_product[i][j] * factor;
-			householder[i][j] = householder[i][j] - outer_product[i][j];
-		}
+	// v has an implicit 1 at the position of the diagonal
+	work.assign(target[column], target[column] + width);
+	for (int k = column + 1; k < num_rows; k++)
+		VectorKernels<T>::axpy(width, conjugate(factors[k][column]), target[k], work.data());
 
-	return householder;
-}
+	VectorKernels<T>::axpy(width, -tau, work.data(), target[column]);
+	for (int k = column + 1; k < num_rows; k++)
+		VectorKernels<T>::axpy(width, -tau * factors[k][column], work.data(), target[k]);
+}
\ No newline at end of file
@@ -1,7 +1,9 @@
 // Matrix.h
 // Defines the Matrix<T> type used in all the algorithms implemented in LinSolver class
+// Matrix<T> stores its elements in a single contiguous row-major buffer, rows, columns and blocks can be accessed without copying through views (MatrixView.h)
 // Defines the Numerical concept
 // Defines the LinSolveBaseException class from which all exceptions explicitly thrown by LinSolve library inherit
+// Arithmetic operators and transpose() build lazy expressions (MatrixExpression.h) evaluated when assigned to a Matrix<T>
 
 #pragma once
 #include<vector>
@@ -9,6 +11,12 @@
 #include<algorithm>
 #include<string>
 #include<exception>
+#include<concepts>
+
+// makes std::complex<double> Numerical, the operators have to be declared before the templates using them
+#include "complex_extensions.h"
+#include "MatrixView.h"
+#include "gemm.h"
 
 // Numerical concept
 // Used by all matrix and linsolver functions (apart from QR decomp.)
@@ -36,79 +44,151 @@ private:
 	std::string e_message;
 };
 
+// System Solver Exceptions
+// thrown when errors occur when solving the system
+// for eg. when the system is not solvable, or when the system is not square
+// declared here so that the sparse and iterative solvers, which LinSolver itself uses, can throw them without including LinSolver.h
+class SystemSolverException : public LinSolveBaseException {
+public:
+	SystemSolverException(const std::string& message) : e_message(message) {}
+	virtual const char* what() const throw() { return e_message.c_str(); }
+private:
+	std::string e_message;
+};
+
+// expression templates of matrix arithmetic, they throw MatrixException
+#include "MatrixExpression.h"
+
 template<Numerical T>
 class Matrix {
 public:
-	Matrix() : _row_count(0), _column_count(0) { resize(_row_count, _column_count); }
-	Matrix(int row_count, int column_count) : _row_count(row_count), _column_count(column_count) { resize(row_count, column_count); }
+	Matrix() : _row_count(0), _column_count(0) {}
+	Matrix(int row_count, int column_count) : _row_count(0), _column_count(0) { resize(row_count, column_count); }
+	explicit Matrix(const MatrixView<const T>& view) : _row_count(0), _column_count(0) { copy_from(view); }
+	// element-wise conversion from a matrix of another type (for example double -> float for mixed precision solvers)
+	template<Numerical U> requires (!std::same_as<U, T> && std::constructible_from<T, U>)
+	explicit Matrix(const Matrix<U>& other) : _row_count(0), _column_count(0) {
+		resize(other.get_row_count(), other.get_column_count());
+		const U* source = other.data();
+		for (size_t i = 0; i < _data.size(); i++) {
+			// copied first, some types convert only from a non-const value
+			U value = source[i];
+			_data[i] = static_cast<T>(value);
+		}
+	}
 
 	Matrix(const Matrix<T>& other) : _row_count(other._row_count), _column_count(other._column_count) {
-		_matrix = other._matrix;
+		_data = other._data;
 	}
-	Matrix(Matrix<T>&& other) : _row_count(other._row_count), _column_count(other._column_count) {
-		_matrix = std::move(other._matrix);
+	Matrix(Matrix<T>&& other) noexcept : _row_count(other._row_count), _column_count(other._column_count) {
+		_data = std::move(other._data);
+		other._row_count = 0;
+		other._column_count = 0;
 	}
 
 	Matrix<T>& operator=(const Matrix<T>& other) {
 		_row_count = other._row_count;
 		_column_count = other._column_count;
-		_matrix = other._matrix;
+		_data = other._data;
 		return *this;
 	}
 
-	Matrix<T>& operator=(Matrix<T>&& other) {
+	Matrix<T>& operator=(Matrix<T>&& other) noexcept {
 		_row_count = other._row_count;
 		_column_count = other._column_count;
-		_matrix = std::move(other._matrix);
+		_data = std::move(other._data);
+		other._row_count = 0;
+		other._column_count = 0;
 		return *this;
 	}
 
+	// evaluates a lazy expression, for example Matrix<T> c = a * b + d;
+	template<MatrixExpression E> requires std::same_as<typename E::value_type, T>
+	Matrix(const E& expression) : _row_count(0), _column_count(0) { assign(expression); }
+	template<MatrixExpression E> requires std::same_as<typename E::value_type, T>
+	Matrix<T>& operator=(const E& expression) {
+		assign(expression);
+		return *this;
+	}
+	friend MatrixOperand<T> as_expression(const Matrix<T>& matrix) { return MatrixOperand<T>(matrix.get_view()); }
+
 	static Matrix<T> identity(int size);
 
 	void print(std::ostream& stream = std::cout) const;
 	int get_row_count() const { return _row_count; }
 	int get_column_count() const { return _column_count; }
+	// distance between the starts of two consecutive rows in the buffer, equal to the column count for an owning matrix
+	int get_leading_dimension() const { return _column_count; }
+
+	T* data() { return _data.data(); }
+	const T* data() const { return _data.data(); }
 
-	std::vector<T>& get_row(int idx) { 
+	VectorView<T> get_row(int idx) { 
 		if (idx >= _row_count)
 			throw MatrixException("Error: incorrect row index");
-		return _matrix[idx]; 
+		return VectorView<T>((*this)[idx], _column_count);
 	}
-	const std::vector<T>& get_row(int idx) const { 
+	VectorView<const T> get_row(int idx) const { 
 		if (idx >= _row_count)
 			throw MatrixException("Error: incorrect row index");
-		return _matrix[idx]; 
+		return VectorView<const T>((*this)[idx], _column_count);
+	}
+	VectorView<T> get_column(int idx) {
+		if (idx >= _column_count)
+			throw MatrixException("Error: incorrect column index");
+		return VectorView<T>(data() + idx, _row_count, _column_count);
+	}
+	VectorView<const T> get_column(int idx) const {
+		if (idx >= _column_count)
+			throw MatrixException("Error: incorrect column index");
+		return VectorView<const T>(data() + idx, _row_count, _column_count);
 	}
-	void set_row(int idx, std::vector<T>& row) { 
+	void set_row(int idx, const std::vector<T>& row) { 
 		if (row.size() != _column_count)
 			throw MatrixException("Error: incorrect row size");
-		_matrix[idx] = row; 
+		std::copy(row.begin(), row.end(), (*this)[idx]);
+	}
+	void set_row(int idx, const VectorView<const T>& row) {
+		if (row.size() != _column_count)
+			throw MatrixException("Error: incorrect row size");
+		get_row(idx).copy_from(row);
 	}
 	std::vector<T> get_column_copy(int idx) const;
 
-	std::vector<T>& operator[](int idx) { return get_row(idx); }
-	const std::vector<T>& operator[](int idx) const { return get_row(idx); }
+	MatrixView<T> get_view() { return MatrixView<T>(data(), _row_count, _column_count, _column_count); }
+	MatrixView<const T> get_view() const { return MatrixView<const T>(data(), _row_count, _column_count, _column_count); }
+	MatrixView<T> get_submatrix(int row, int column, int row_count, int column_count);
+	MatrixView<const T> get_submatrix(int row, int column, int row_count, int column_count) const;
+
+	// unchecked row access, returns pointer to the first element of the row so that matrix[i][j] works as before
+	T* operator[](int idx) { return data() + static_cast<size_t>(idx) * _column_count; }
+	const T* operator[](int idx) const { return data() + static_cast<size_t>(idx) * _column_count; }
 
 	// access operator by (), especially useful for vectors represented by matricies
-	T& operator()(int i, int j = 0) { return _matrix[i][j]; }
-	const T& operator()(int i, int j = 0) const { return _matrix[i][j]; }
+	T& operator()(int i, int j = 0) { return _data[static_cast<size_t>(i) * _column_count + j]; }
+	const T& operator()(int i, int j = 0) const { return _data[static_cast<size_t>(i) * _column_count + j]; }
 
-	T& get_value(int row, int column) { return _matrix[row][column]; }
-	const T& get_value(int row, int column) const { return _matrix[row][column]; }
+	T& get_value(int row, int column) { return (*this)(row, column); }
+	const T& get_value(int row, int column) const { return (*this)(row, column); }
 
-	void set_value(int row, int column, T value) { _matrix[row][column] = value; }
+	void set_value(int row, int column, T value) { (*this)(row, column) = value; }
 
-	Matrix<T> transpose() const;
+	// lazy transpose, no elements are copied until it is assigned to a matrix
+	MatrixOperand<T> transpose() const { return MatrixOperand<T>(get_view(), true); }
 	bool is_square() const { return _row_count == _column_count; }
 	void resize(int row_count, int column_count);
 
-	Matrix<T> operator+(const Matrix<T>& other);
-	Matrix<T> operator*(const Matrix<T>& other);
+	// y = A * x, x has column_count and y row_count elements (the operator interface used by iterative solvers)
+	void multiply(const T* x, T* y) const;
 
 	void copy_from(const Matrix<T>& source);
+	void copy_from(const MatrixView<const T>& source);
 
 private:
-	std::vector<std::vector<T>> _matrix;
+	template<MatrixExpression E>
+	void assign(const E& expression);
+
+	std::vector<T> _data;
 	int _row_count;
 	int _column_count;
 };
@@ -126,70 +206,76 @@ Matrix<T> Matrix<T>::identity(int size)
 // prints the matrix to given ostream, default is standard output
 template<Numerical T>
 void Matrix<T>::print(std::ostream& stream) const {
-	for (auto&& row : _matrix) {
-		std::copy(row.begin(), row.end(), std::ostream_iterator<T>(stream, " "));
+	for (int i = 0; i < _row_count; i++) {
+		for (int j = 0; j < _column_count; j++)
+			stream << (*this)(i, j) << " ";
 		stream << std::endl;
 	}
 }
 
 template<Numerical T>
 std::vector<T> Matrix<T>::get_column_copy(int idx) const {
-	if (idx >= _column_count)
-		throw MatrixException("Error: incorrect column index");
-	std::vector<T> column;
-	for (auto&& row : _matrix)
-		column.push_back(row[idx]);
-	return column;
+	return get_column(idx).to_vector();
 }
 
+// returns a view of the block starting at (row, column), no elements are copied
 template<Numerical T>
-Matrix<T> Matrix<T>::operator+(const Matrix<T>& other) {
-	if (_column_count != other._column_count)
-		throw MatrixException("Different number of columns");
-	if (_row_count != other._row_count)
-		throw MatrixException("Different number of rows");
-
-	Matrix<T> sum(_row_count, _column_count);
-	for (size_t i = 0; i < _row_count; i++)
-		for (size_t j = 0; j < _column_count; j++)
-			sum._matrix[i][j] = _matrix[i][j] + other._matrix[i][j];
-	return sum;
+MatrixView<T> Matrix<T>::get_submatrix(int row, int column, int row_count, int column_count) {
+	if (row < 0 || column < 0 || row_count < 0 || column_count < 0 || row + row_count > _row_count || column + column_count > _column_count)
+		throw MatrixException("Error: submatrix out of range");
+	return get_view().get_submatrix(row, column, row_count, column_count);
 }
 
-// basic n^3 matrix multiplication
 template<Numerical T>
-Matrix<T> Matrix<T>::operator*(const Matrix<T>& other) {
-	if (_column_count != other._row_count)
-		throw MatrixException("Error when multiplying matricies: incompatible dimensions.");
-
-	Matrix<T> product(_row_count, other._column_count);
-	for (int i = 0; i < _row_count; i++)
-		for (int j = 0; j < other._column_count; j++) 
-		{
-			T curr = {};
-			for (int k = 0; k < _column_count; k++)
-				curr = curr + _matrix[i][k] * other._matrix[k][j];
-			product[i][j] = curr;
-		}
-	return product;
+MatrixView<const T> Matrix<T>::get_submatrix(int row, int column, int row_count, int column_count) const {
+	if (row < 0 || column < 0 || row_count < 0 || column_count < 0 || row + row_count > _row_count || column + column_count > _column_count)
+		throw MatrixException("Error: submatrix out of range");
+	return get_view().get_submatrix(row, column, row_count, column_count);
 }
 
+// The result is written directly into the matrix, an expression reading the matrix itself (a = a.transpose() * b) is evaluated into a new buffer first
 template<Numerical T>
-void Matrix<T>::resize(int row_count, int column_count) {
-	_row_count = row_count;
-	_column_count = column_count;
-	_matrix.resize(row_count);
-	for (auto&& row : _matrix)
-		row.resize(column_count);
+template<MatrixExpression E>
+void Matrix<T>::assign(const E& expression) {
+	if (expression.aliases(data(), data() + _data.size())) {
+		Matrix<T> result(expression);
+		*this = std::move(result);
+		return;
+	}
+	_row_count = expression.get_row_count();
+	_column_count = expression.get_column_count();
+	_data.resize(static_cast<size_t>(_row_count) * _column_count);
+	expression.evaluate(get_view(), T(1), false);
 }
 
+// matrix-vector product, large matrices are split into blocks of rows multiplied in parallel
 template<Numerical T>
-Matrix<T> Matrix<T>::transpose() const {
-	Matrix<T> transposed(_column_count, _row_count);
-	for (int i = 0; i < _row_count; i++)
-		for (int j = 0; j < _column_count; j++)
-			transposed[j][i] = _matrix[i][j];
-	return transposed;
+void Matrix<T>::multiply(const T* x, T* y) const {
+	const int rows_per_block = std::max(1, (1 << 16) / std::max(1, _column_count));
+	auto multiply_rows = [&](int block) {
+		int last = std::min((block + 1) * rows_per_block, _row_count);
+		for (int i = block * rows_per_block; i < last; i++)
+			y[i] = VectorKernels<T>::dot(_column_count, (*this)[i], x);
+	};
+	ThreadPool::instance().parallel_for(0, (_row_count + rows_per_block - 1) / rows_per_block, multiply_rows);
+}
+
+// resizes the matrix, elements that fit into the new dimensions keep their positions
+template<Numerical T>
+void Matrix<T>::resize(int row_count, int column_count) {
+	if (column_count == _column_count || _row_count == 0) {
+		_data.resize(static_cast<size_t>(row_count) * column_count);
+	}
+	else {
+		std::vector<T> resized(static_cast<size_t>(row_count) * column_count);
+		int rows_to_keep = std::min(row_count, _row_count);
+		int columns_to_keep = std::min(column_count, _column_count);
+		for (int i = 0; i < rows_to_keep; i++)
+			std::copy((*this)[i], (*this)[i] + columns_to_keep, resized.begin() + static_cast<size_t>(i) * column_count);
+		_data = std::move(resized);
+	}
+	_row_count = row_count;
+	_column_count = column_count;
 }
 
 // copies the values from source to this matrix
@@ -197,8 +283,14 @@ template<Numerical T>
 void Matrix<T>::copy_from(const Matrix<T>& source) {
 	_row_count = source._row_count;
 	_column_count = source._column_count;
-	resize(_row_count, _column_count);
-	for (int i = 0; i < _row_count; i++)
-		for (int j = 0; j < _column_count; j++)
-			_matrix[i][j] = source._matrix[i][j];
-}
\ No newline at end of file
+	_data = source._data;
+}
+
+// copies the values of a view (eg. a block of another matrix) to this matrix
+template<Numerical T>
+void Matrix<T>::copy_from(const MatrixView<const T>& source) {
+	_row_count = source.get_row_count();
+	_column_count = source.get_column_count();
+	_data.resize(static_cast<size_t>(_row_count) * _column_count);
+	get_view().copy_from(source);
+}
@@ -0,0 +1,257 @@
+// MatrixExpression.h
+// Lazy evaluation of matrix arithmetic by expression templates
+// operator+, operator-, operator* and transpose() of Matrix<T> compute nothing, they return small objects describing the expression
+// (views of the operand matrices and scalars); the expression is evaluated when it is assigned to a Matrix<T> or a Matrix<T> is constructed from it:
+// - sums, differences, scalings and transposes are fused into a single loop over the elements of the result, without temporaries
+// - a transpose is never copied, a transposed operand reads its element (i, j) at (j, i) and is passed to Gemm as the transpose flag;
+//   the transpose of a compound expression is pushed down to its operands ((A * B)^T = B^T * A^T)
+// - products are computed by Gemm directly into the result: scalings of a product become its alpha and a product in a sum
+//   is accumulated into the result with beta = 1 (D + A * B is a copy of D and one Gemm call); only operands of a product
+//   that are compound expressions themselves (as A * B in A * B * C) are evaluated into a temporary
+// Expressions keep views of their operands, so they have to be evaluated before the operand matrices are destroyed
+// Included by Matrix.h after the definition of the exceptions
+
+#pragma once
+#include<vector>
+#include<concepts>
+#include<functional>
+#include<type_traits>
+
+#include "MatrixView.h"
+#include "gemm.h"
+
+// MatrixExpression concept
+// Nodes of lazy expressions, evaluate(target, scale, accumulate) computes target = scale * expression (+ target when accumulate)
+// Nodes with elementwise == true also give their element (i, j) by at(i, j), so enclosing sums and scalings can be fused with them
+template<typename E>
+concept MatrixExpression = requires(const E& e, const MatrixView<typename E::value_type>& target, const typename E::value_type* pointer) {
+	{ E::elementwise } -> std::convertible_to<bool>;
+	{ e.get_row_count() } -> std::convertible_to<int>;
+	{ e.get_column_count() } -> std::convertible_to<int>;
+	e.evaluate(target, typename E::value_type(1), true);
+	{ e.aliases(pointer, pointer) } -> std::convertible_to<bool>;
+};
+
+template<MatrixExpression E>
+const E& as_expression(const E& expression) { return expression; }
+
+// Anything an expression can be built from: another expression or a matrix (Matrix<T> has as_expression)
+template<typename X>
+concept MatrixExpressionArgument = requires(const X& x) { requires MatrixExpression<std::remove_cvref_t<decltype(as_expression(x))>>; };
+
+template<MatrixExpressionArgument X>
+using matrix_expression_t = std::remove_cvref_t<decltype(as_expression(std::declval<const X&>()))>;
+
+namespace expression_detail {
+	// target = scale * expression (+ target), one pass over the elements
+	template<typename E, typename T>
+	void evaluate_elementwise(const E& expression, const MatrixView<T>& target, const T scale, const bool accumulate) {
+		const bool unit = scale == 1;
+		for (int i = 0; i < target.get_row_count(); i++) {
+			T* row = target[i];
+			if (unit && !accumulate)
+				for (int j = 0; j < target.get_column_count(); j++)
+					row[j] = expression.at(i, j);
+			else if (unit)
+				for (int j = 0; j < target.get_column_count(); j++)
+					row[j] = row[j] + expression.at(i, j);
+			else if (!accumulate)
+				for (int j = 0; j < target.get_column_count(); j++)
+					row[j] = scale * expression.at(i, j);
+			else
+				for (int j = 0; j < target.get_column_count(); j++)
+					row[j] = row[j] + scale * expression.at(i, j);
+		}
+	}
+}
+
+// Leaf of an expression: a view of a matrix, possibly transposed
+template<typename T>
+class MatrixOperand {
+public:
+	using value_type = T;
+	static constexpr bool elementwise = true;
+
+	explicit MatrixOperand(const MatrixView<const T>& view, const bool transposed = false) : _view(view), _transposed(transposed) {}
+
+	int get_row_count() const { return _transposed ? _view.get_column_count() : _view.get_row_count(); }
+	int get_column_count() const { return _transposed ? _view.get_row_count() : _view.get_column_count(); }
+	T at(int i, int j) const { return _transposed ? _view(j, i) : _view(i, j); }
+
+	const MatrixView<const T>& get_view() const { return _view; }
+	bool is_transposed() const { return _transposed; }
+	MatrixOperand<T> transpose() const { return MatrixOperand<T>(_view, !_transposed); }
+
+	void evaluate(const MatrixView<T>& target, const T scale, const bool accumulate) const {
+		expression_detail::evaluate_elementwise(*this, target, scale, accumulate);
+	}
+	// the viewed elements overlap the array [begin, end)
+	bool aliases(const T* begin, const T* end) const {
+		if (_view.get_row_count() == 0 || _view.get_column_count() == 0)
+			return false;
+		const T* first = _view.data();
+		const T* last = _view[_view.get_row_count() - 1] + _view.get_column_count();
+		return std::less<const T*>()(first, end) && std::less<const T*>()(begin, last);
+	}
+
+private:
+	MatrixView<const T> _view;
+	bool _transposed;
+};
+
+// left + right or left - right
+template<MatrixExpression L, MatrixExpression R, bool Subtract>
+class MatrixSum {
+public:
+	using value_type = typename L::value_type;
+	static constexpr bool elementwise = L::elementwise && R::elementwise;
+
+	MatrixSum(const L& left, const R& right) : _left(left), _right(right) {
+		if (left.get_column_count() != right.get_column_count())
+			throw MatrixException("Different number of columns");
+		if (left.get_row_count() != right.get_row_count())
+			throw MatrixException("Different number of rows");
+	}
+
+	int get_row_count() const { return _left.get_row_count(); }
+	int get_column_count() const { return _left.get_column_count(); }
+	value_type at(int i, int j) const requires elementwise {
+		return Subtract ? _left.at(i, j) - _right.at(i, j) : _left.at(i, j) + _right.at(i, j);
+	}
+
+	auto transpose() const {
+		using LT = decltype(_left.transpose());
+		using RT = decltype(_right.transpose());
+		return MatrixSum<LT, RT, Subtract>(_left.transpose(), _right.transpose());
+	}
+
+	// sums containing products are evaluated term by term, every product accumulates into the target by Gemm
+	void evaluate(const MatrixView<value_type>& target, const value_type scale, const bool accumulate) const {
+		if constexpr (elementwise)
+			expression_detail::evaluate_elementwise(*this, target, scale, accumulate);
+		else {
+			_left.evaluate(target, scale, accumulate);
+			_right.evaluate(target, Subtract ? -scale : scale, true);
+		}
+	}
+	bool aliases(const value_type* begin, const value_type* end) const { return _left.aliases(begin, end) || _right.aliases(begin, end); }
+
+private:
+	L _left;
+	R _right;
+};
+
+// scale * expression
+template<MatrixExpression E>
+class ScaledMatrix {
+public:
+	using value_type = typename E::value_type;
+	static constexpr bool elementwise = E::elementwise;
+
+	ScaledMatrix(const E& expression, const value_type scale) : _expression(expression), _scale(scale) {}
+
+	int get_row_count() const { return _expression.get_row_count(); }
+	int get_column_count() const { return _expression.get_column_count(); }
+	value_type at(int i, int j) const requires elementwise { return _scale * _expression.at(i, j); }
+
+	const E& get_expression() const { return _expression; }
+	value_type get_scale() const { return _scale; }
+	auto transpose() const { return ScaledMatrix<decltype(_expression.transpose())>(_expression.transpose(), _scale); }
+
+	void evaluate(const MatrixView<value_type>& target, const value_type scale, const bool accumulate) const {
+		_expression.evaluate(target, scale * _scale, accumulate);
+	}
+	bool aliases(const value_type* begin, const value_type* end) const { return _expression.aliases(begin, end); }
+
+private:
+	E _expression;
+	value_type _scale;
+};
+
+// left * right, evaluated by one Gemm call into the target
+template<MatrixExpression L, MatrixExpression R>
+class MatrixProduct {
+public:
+	using value_type = typename L::value_type;
+	static constexpr bool elementwise = false;
+
+	MatrixProduct(const L& left, const R& right) : _left(left), _right(right) {
+		if (left.get_column_count() != right.get_row_count())
+			throw MatrixException("Error when multiplying matricies: incompatible dimensions.");
+	}
+
+	int get_row_count() const { return _left.get_row_count(); }
+	int get_column_count() const { return _right.get_column_count(); }
+
+	auto transpose() const {
+		using LT = decltype(_left.transpose());
+		using RT = decltype(_right.transpose());
+		return MatrixProduct<RT, LT>(_right.transpose(), _left.transpose());
+	}
+
+	void evaluate(const MatrixView<value_type>& target, const value_type scale, const bool accumulate) const {
+		value_type alpha = scale;
+		std::vector<value_type> left_storage, right_storage;
+		MatrixOperand<value_type> a = gemm_operand(_left, left_storage, alpha);
+		MatrixOperand<value_type> b = gemm_operand(_right, right_storage, alpha);
+		Gemm::multiply<value_type>(a.get_view(), a.is_transposed(), b.get_view(), b.is_transposed(), target, alpha, accumulate ? value_type(1) : value_type(0));
+	}
+	bool aliases(const value_type* begin, const value_type* end) const { return _left.aliases(begin, end) || _right.aliases(begin, end); }
+
+private:
+	// the factor as a (possibly transposed) view for Gemm: operands are used directly, scalings are moved to alpha,
+	// anything else is evaluated into the storage
+	template<MatrixExpression E>
+	static MatrixOperand<value_type> gemm_operand(const E& expression, std::vector<value_type>& storage, value_type& alpha) {
+		if constexpr (std::is_same_v<E, MatrixOperand<value_type>>)
+			return expression;
+		else if constexpr (requires { expression.get_scale(); }) {
+			alpha = alpha * expression.get_scale();
+			return gemm_operand(expression.get_expression(), storage, alpha);
+		}
+		else {
+			int row_count = expression.get_row_count(), column_count = expression.get_column_count();
+			storage.assign(static_cast<size_t>(row_count) * column_count, value_type(0));
+			MatrixView<value_type> view(storage.data(), row_count, column_count, column_count);
+			expression.evaluate(view, value_type(1), false);
+			return MatrixOperand<value_type>(view);
+		}
+	}
+
+	L _left;
+	R _right;
+};
+
+template<MatrixExpressionArgument L, MatrixExpressionArgument R>
+	requires std::same_as<typename matrix_expression_t<L>::value_type, typename matrix_expression_t<R>::value_type>
+auto operator+(const L& left, const R& right) {
+	return MatrixSum<matrix_expression_t<L>, matrix_expression_t<R>, false>(as_expression(left), as_expression(right));
+}
+
+template<MatrixExpressionArgument L, MatrixExpressionArgument R>
+	requires std::same_as<typename matrix_expression_t<L>::value_type, typename matrix_expression_t<R>::value_type>
+auto operator-(const L& left, const R& right) {
+	return MatrixSum<matrix_expression_t<L>, matrix_expression_t<R>, true>(as_expression(left), as_expression(right));
+}
+
+template<MatrixExpressionArgument L, MatrixExpressionArgument R>
+	requires std::same_as<typename matrix_expression_t<L>::value_type, typename matrix_expression_t<R>::value_type>
+auto operator*(const L& left, const R& right) {
+	return MatrixProduct<matrix_expression_t<L>, matrix_expression_t<R>>(as_expression(left), as_expression(right));
+}
+
+template<MatrixExpressionArgument E>
+auto operator*(const typename matrix_expression_t<E>::value_type& scale, const E& expression) {
+	return ScaledMatrix<matrix_expression_t<E>>(as_expression(expression), scale);
+}
+
+template<MatrixExpressionArgument E>
+auto operator*(const E& expression, const typename matrix_expression_t<E>::value_type& scale) {
+	return ScaledMatrix<matrix_expression_t<E>>(as_expression(expression), scale);
+}
+
+template<MatrixExpressionArgument E>
+auto operator-(const E& expression) {
+	using T = typename matrix_expression_t<E>::value_type;
+	return ScaledMatrix<matrix_expression_t<E>>(as_expression(expression), T(-1));
+}
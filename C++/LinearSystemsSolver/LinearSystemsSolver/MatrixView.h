@@ -0,0 +1,94 @@
+// MatrixView.h
+// Defines non-owning views into the contiguous row-major storage used by Matrix<T>
+// VectorView<T> is a strided sequence of elements (a row or a column of a matrix)
+// MatrixView<T> is a rectangular block of a matrix described by its first element, its dimensions and its leading dimension (distance between the starts of two consecutive rows)
+// Views never allocate, they are only valid while the viewed matrix is alive and not resized
+// Read-only views are created by using const T as the template parameter, eg. MatrixView<const double>
+
+#pragma once
+#include<vector>
+#include<utility>
+#include<type_traits>
+
+template<typename T>
+class VectorView {
+public:
+	VectorView() : _data(nullptr), _size(0), _stride(1) {}
+	VectorView(T* data, int size, int stride = 1) : _data(data), _size(size), _stride(stride) {}
+
+	// every view can be converted to a read-only view of the same elements
+	template<typename U> requires std::is_same_v<const U, T>
+	VectorView(const VectorView<U>& other) : _data(other.data()), _size(other.size()), _stride(other.stride()) {}
+
+	int size() const { return _size; }
+	int stride() const { return _stride; }
+	T* data() const { return _data; }
+
+	T& operator[](int idx) const { return _data[idx * _stride]; }
+	T& operator()(int idx) const { return _data[idx * _stride]; }
+
+	// swaps the elements of two views of the same size (used for switching rows without allocating)
+	void swap_with(const VectorView<T>& other) const {
+		for (int i = 0; i < _size; i++)
+			std::swap((*this)[i], other[i]);
+	}
+
+	void copy_from(const VectorView<const std::remove_const_t<T>>& source) const {
+		for (int i = 0; i < _size; i++)
+			(*this)[i] = source[i];
+	}
+
+	std::vector<std::remove_const_t<T>> to_vector() const {
+		std::vector<std::remove_const_t<T>> copy(_size);
+		for (int i = 0; i < _size; i++)
+			copy[i] = (*this)[i];
+		return copy;
+	}
+
+private:
+	T* _data;
+	int _size;
+	int _stride;
+};
+
+template<typename T>
+class MatrixView {
+public:
+	MatrixView() : _data(nullptr), _row_count(0), _column_count(0), _leading_dimension(0) {}
+	MatrixView(T* data, int row_count, int column_count, int leading_dimension)
+		: _data(data), _row_count(row_count), _column_count(column_count), _leading_dimension(leading_dimension) {}
+
+	template<typename U> requires std::is_same_v<const U, T>
+	MatrixView(const MatrixView<U>& other)
+		: _data(other.data()), _row_count(other.get_row_count()), _column_count(other.get_column_count()), _leading_dimension(other.get_leading_dimension()) {}
+
+	int get_row_count() const { return _row_count; }
+	int get_column_count() const { return _column_count; }
+	int get_leading_dimension() const { return _leading_dimension; }
+	bool is_square() const { return _row_count == _column_count; }
+	T* data() const { return _data; }
+
+	// unchecked access, returns pointer to the first element of the row
+	T* operator[](int idx) const { return _data + static_cast<size_t>(idx) * _leading_dimension; }
+	T& operator()(int i, int j = 0) const { return _data[static_cast<size_t>(i) * _leading_dimension + j]; }
+
+	VectorView<T> get_row(int idx) const { return VectorView<T>((*this)[idx], _column_count, 1); }
+	VectorView<T> get_column(int idx) const { return VectorView<T>(_data + idx, _row_count, _leading_dimension); }
+
+	// returns view of the block starting at (row, column) with given dimensions
+	MatrixView<T> get_submatrix(int row, int column, int row_count, int column_count) const {
+		return MatrixView<T>((*this)[row] + column, row_count, column_count, _leading_dimension);
+	}
+
+	void copy_from(const MatrixView<const std::remove_const_t<T>>& source) const {
+		for (int i = 0; i < _row_count; i++)
+			for (int j = 0; j < _column_count; j++)
+				(*this)(i, j) = source(i, j);
+	}
+
+private:
+	T* _data;
+	int _row_count;
+	int _column_count;
+	int _leading_dimension;
+};
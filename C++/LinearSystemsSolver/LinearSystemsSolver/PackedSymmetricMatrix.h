@@ -0,0 +1,93 @@
+// PackedSymmetricMatrix.h
+// Defines the PackedSymmetricMatrix<T> type, a symmetric matrix of which only the lower triangle is stored
+// The triangle is packed row by row: row i holds the elements (i, 0) ... (i, i) and starts at position i * (i + 1) / 2,
+// so every row is a contiguous array and the matrix takes n * (n + 1) / 2 elements instead of n * n
+// Used by the packed Cholesky factorization in LinSolver, which overwrites the triangle by the factor L
+
+#pragma once
+#include<vector>
+#include<iostream>
+
+#include "Matrix.h"
+
+template<Numerical T>
+class PackedSymmetricMatrix {
+public:
+	PackedSymmetricMatrix() : _size(0) {}
+	explicit PackedSymmetricMatrix(int size) : _size(size), _data(packed_size(size), T(0)) {}
+
+	// takes the lower triangle of a square matrix, the upper triangle is not read
+	static PackedSymmetricMatrix<T> from_dense(const Matrix<T>& matrix);
+	// the full symmetric matrix
+	Matrix<T> to_dense() const;
+
+	int get_size() const { return _size; }
+	int get_row_count() const { return _size; }
+	int get_column_count() const { return _size; }
+	size_t get_stored_count() const { return _data.size(); }
+
+	// row i of the lower triangle, elements (i, 0) ... (i, i)
+	T* row(int i) { return _data.data() + packed_size(i); }
+	const T* row(int i) const { return _data.data() + packed_size(i); }
+
+	// element (i, j), both (i, j) and (j, i) refer to the same stored element
+	T& operator()(int i, int j) { return i >= j ? row(i)[j] : row(j)[i]; }
+	const T& operator()(int i, int j) const { return i >= j ? row(i)[j] : row(j)[i]; }
+
+	// y = A * x, the operator interface used by iterative solvers
+	void multiply(const T* x, T* y) const;
+
+	void print(std::ostream& stream = std::cout) const;
+
+private:
+	static size_t packed_size(int size) { return static_cast<size_t>(size) * (static_cast<size_t>(size) + 1) / 2; }
+
+	int _size;
+	std::vector<T> _data;
+};
+
+template<Numerical T>
+PackedSymmetricMatrix<T> PackedSymmetricMatrix<T>::from_dense(const Matrix<T>& matrix)
+{
+	if (!matrix.is_square())
+		throw MatrixException("Error: symmetric matrix has to be square");
+	PackedSymmetricMatrix<T> packed(matrix.get_row_count());
+	for (int i = 0; i < packed._size; i++)
+		std::copy(matrix[i], matrix[i] + i + 1, packed.row(i));
+	return packed;
+}
+
+template<Numerical T>
+Matrix<T> PackedSymmetricMatrix<T>::to_dense() const
+{
+	Matrix<T> dense(_size, _size);
+	for (int i = 0; i < _size; i++)
+		for (int j = 0; j <= i; j++) {
+			dense[i][j] = row(i)[j];
+			dense[j][i] = row(i)[j];
+		}
+	return dense;
+}
+
+// Row i of the triangle contributes to y(i) by a dot product and to y(0) ... y(i - 1) as column i of the upper triangle
+template<Numerical T>
+void PackedSymmetricMatrix<T>::multiply(const T* x, T* y) const
+{
+	for (int i = 0; i < _size; i++)
+		y[i] = 0;
+	for (int i = 0; i < _size; i++) {
+		const T* row_i = row(i);
+		y[i] = y[i] + VectorKernels<T>::dot(i + 1, row_i, x);
+		VectorKernels<T>::axpy(i, x[i], row_i, y);
+	}
+}
+
+template<Numerical T>
+void PackedSymmetricMatrix<T>::print(std::ostream& stream) const
+{
+	for (int i = 0; i < _size; i++) {
+		for (int j = 0; j < _size; j++)
+			stream << (*this)(i, j) << " ";
+		stream << std::endl;
+	}
+}
@@ -0,0 +1,231 @@
+// Preconditioner.h
+// Preconditioners for the Krylov solvers of IterativeSolver.h: diagonal Jacobi, incomplete LU without fill-in (ILU(0)) and SSOR
+// A preconditioner approximates the inverse of the matrix, apply(r, z) computes z = M^-1 * r
+// Any type with such an apply method satisfies the Preconditioner concept and can be passed to the solvers
+// ILU(0) keeps the symbolic part of the factorization, so the matrix can be refactorized when its values change but its pattern stays the same
+
+#pragma once
+#include<vector>
+#include<algorithm>
+
+#include "Matrix.h"
+#include "SparseMatrix.h"
+
+// Preconditioner concept
+// z = M^-1 * r for arrays of the size of the system, r and z do not overlap
+template<typename P, typename T>
+concept Preconditioner = requires(const P& preconditioner, const T* r, T* z) {
+	preconditioner.apply(r, z);
+};
+
+// M = I, the solvers without preconditioning
+template<Numerical T>
+class IdentityPreconditioner {
+public:
+	explicit IdentityPreconditioner(int size = 0) : _size(size) {}
+	void apply(const T* r, T* z) const { std::copy(r, r + _size, z); }
+	void set_size(int size) { _size = size; }
+private:
+	int _size;
+};
+
+// M = D, the diagonal of the matrix
+template<Numerical T>
+class JacobiPreconditioner {
+public:
+	JacobiPreconditioner() = default;
+	explicit JacobiPreconditioner(const SparseMatrix<T>& matrix) { factorize(matrix); }
+	explicit JacobiPreconditioner(const Matrix<T>& matrix) { factorize(matrix); }
+
+	void factorize(const SparseMatrix<T>& matrix) {
+		_diagonal.resize(matrix.get_row_count());
+		for (int i = 0; i < matrix.get_row_count(); i++)
+			_diagonal[i] = matrix.get_value(i, i);
+		check_diagonal();
+	}
+	void factorize(const Matrix<T>& matrix) {
+		_diagonal.resize(matrix.get_row_count());
+		for (int i = 0; i < matrix.get_row_count(); i++)
+			_diagonal[i] = matrix(i, i);
+		check_diagonal();
+	}
+
+	int get_size() const { return static_cast<int>(_diagonal.size()); }
+	void apply(const T* r, T* z) const {
+		for (int i = 0; i < get_size(); i++)
+			z[i] = r[i] / _diagonal[i];
+	}
+
+private:
+	void check_diagonal() const {
+		for (auto&& value : _diagonal)
+			if (value == 0)
+				throw SystemSolverException("Error: cannot build Jacobi preconditioner, zero on the matrixs diagonal");
+	}
+
+	std::vector<T> _diagonal;
+};
+
+// M = L * U where L and U have the sparsity pattern of the matrix, fill-in outside the pattern is dropped
+template<Numerical T>
+class ILU0Preconditioner {
+public:
+	ILU0Preconditioner() = default;
+	explicit ILU0Preconditioner(const SparseMatrix<T>& matrix) { factorize(matrix); }
+	explicit ILU0Preconditioner(const Matrix<T>& matrix) { factorize(SparseMatrix<T>::from_dense(matrix)); }
+
+	// the first call (or a call with a different pattern) analyses the pattern, later calls only recompute the values
+	void factorize(const SparseMatrix<T>& matrix);
+	bool has_same_pattern(const SparseMatrix<T>& matrix) const;
+
+	int get_size() const { return _factors.get_row_count(); }
+	// L (below the diagonal, unit diagonal not stored) and U (on and above the diagonal) on the pattern of the matrix
+	const SparseMatrix<T>& get_factors() const { return _factors; }
+
+	void apply(const T* r, T* z) const {
+		_factors.solve_lower(r, z, true);
+		_factors.solve_upper(z, z);
+	}
+
+private:
+	void analyse_pattern();
+
+	SparseMatrix<T> _factors;
+	// index of the diagonal element of every row in the values array
+	std::vector<int> _diagonal_positions;
+	// for every element a_ij below the diagonal, the elements a_kj (k = column of a_ij) of row k used in its update
+	// are listed as pairs (index in row i, index in row k) in _updates[_update_starts[e]] ... _updates[_update_starts[e + 1] - 1]
+	std::vector<int> _update_starts;
+	std::vector<std::pair<int, int>> _updates;
+};
+
+// M = (D / w + L) * (D / w)^-1 * (D / w + U) * w / (2 - w), the preconditioner of one symmetric SOR step
+template<Numerical T>
+class SSORPreconditioner {
+public:
+	SSORPreconditioner() = default;
+	explicit SSORPreconditioner(const SparseMatrix<T>& matrix, const T relaxation = T(1)) { factorize(matrix, relaxation); }
+	explicit SSORPreconditioner(const Matrix<T>& matrix, const T relaxation = T(1)) { factorize(SparseMatrix<T>::from_dense(matrix), relaxation); }
+
+	void factorize(const SparseMatrix<T>& matrix, const T relaxation = T(1));
+
+	int get_size() const { return _matrix.get_row_count(); }
+	void apply(const T* r, T* z) const;
+
+private:
+	SparseMatrix<T> _matrix;
+	std::vector<T> _diagonal;
+	T _relaxation = T(1);
+	// w * (2 - w)
+	T _scale = T(1);
+};
+
+template<Numerical T>
+bool ILU0Preconditioner<T>::has_same_pattern(const SparseMatrix<T>& matrix) const
+{
+	return matrix.get_row_count() == _factors.get_row_count() && matrix.get_column_count() == _factors.get_column_count()
+		&& matrix.get_row_starts() == _factors.get_row_starts() && matrix.get_column_indices() == _factors.get_column_indices();
+}
+
+template<Numerical T>
+void ILU0Preconditioner<T>::factorize(const SparseMatrix<T>& matrix)
+{
+	if (!matrix.is_square())
+		throw SystemSolverException("Error: cannot build ILU(0) preconditioner, matrix is not square");
+	if (has_same_pattern(matrix) && !_diagonal_positions.empty())
+		_factors.get_values() = matrix.get_values();
+	else {
+		_factors = matrix;
+		analyse_pattern();
+	}
+
+	// IKJ variant of Gaussian elimination restricted to the pattern
+	std::vector<T>& values = _factors.get_values();
+	const std::vector<int>& row_starts = _factors.get_row_starts();
+	const std::vector<int>& columns = _factors.get_column_indices();
+	for (int i = 0; i < get_size(); i++) {
+		for (int e = row_starts[i]; e < row_starts[i + 1] && columns[e] < i; e++) {
+			values[e] = values[e] / values[_diagonal_positions[columns[e]]];
+			for (int u = _update_starts[e]; u < _update_starts[e + 1]; u++)
+				values[_updates[u].first] = values[_updates[u].first] - values[e] * values[_updates[u].second];
+		}
+		if (values[_diagonal_positions[i]] == 0)
+			throw SystemSolverException("Error: cannot build ILU(0) preconditioner, zero pivot");
+	}
+}
+
+// Finds the diagonal positions and, for every element a_ik left of the diagonal, the pairs (a_ij, a_kj) with j > k both in the pattern,
+// so refactorizations do not search the rows again
+template<Numerical T>
+void ILU0Preconditioner<T>::analyse_pattern()
+{
+	int size = get_size();
+	const std::vector<int>& row_starts = _factors.get_row_starts();
+	const std::vector<int>& columns = _factors.get_column_indices();
+
+	_diagonal_positions.assign(size, -1);
+	for (int i = 0; i < size; i++) {
+		_diagonal_positions[i] = _factors.find(i, i);
+		if (_diagonal_positions[i] < 0)
+			throw SystemSolverException("Error: cannot build ILU(0) preconditioner, diagonal element is not in the pattern");
+	}
+
+	_update_starts.assign(_factors.get_nonzero_count() + 1, 0);
+	_updates.clear();
+	// position of column j in the current row i, -1 if not present
+	std::vector<int> position(size, -1);
+	for (int i = 0; i < size; i++) {
+		for (int e = row_starts[i]; e < row_starts[i + 1]; e++)
+			position[columns[e]] = e;
+		for (int e = row_starts[i]; e < row_starts[i + 1]; e++) {
+			int k = columns[e];
+			if (k < i)
+				for (int f = _diagonal_positions[k] + 1; f < row_starts[k + 1]; f++)
+					if (position[columns[f]] >= 0)
+						_updates.emplace_back(position[columns[f]], f);
+			_update_starts[e + 1] = static_cast<int>(_updates.size());
+		}
+		for (int e = row_starts[i]; e < row_starts[i + 1]; e++)
+			position[columns[e]] = -1;
+	}
+}
+
+template<Numerical T>
+void SSORPreconditioner<T>::factorize(const SparseMatrix<T>& matrix, const T relaxation)
+{
+	if (!matrix.is_square())
+		throw SystemSolverException("Error: cannot build SSOR preconditioner, matrix is not square");
+	_matrix = matrix;
+	_diagonal.resize(get_size());
+	for (int i = 0; i < get_size(); i++) {
+		_diagonal[i] = _matrix.get_value(i, i);
+		if (_diagonal[i] == 0)
+			throw SystemSolverException("Error: cannot build SSOR preconditioner, zero on the matrixs diagonal");
+	}
+	_relaxation = relaxation;
+	_scale = _relaxation * (T(2) - _relaxation);
+}
+
+// z = w * (2 - w) * (D + w * U)^-1 * D * (D + w * L)^-1 * r, a forward and a backward substitution
+template<Numerical T>
+void SSORPreconditioner<T>::apply(const T* r, T* z) const
+{
+	const std::vector<int>& row_starts = _matrix.get_row_starts();
+	const std::vector<int>& columns = _matrix.get_column_indices();
+	const std::vector<T>& values = _matrix.get_values();
+	int size = get_size();
+	for (int i = 0; i < size; i++) {
+		T sum = 0;
+		for (int k = row_starts[i]; k < row_starts[i + 1] && columns[k] < i; k++)
+			sum = sum + values[k] * z[columns[k]];
+		z[i] = (r[i] - _relaxation * sum) / _diagonal[i];
+	}
+	for (int i = size - 1; i >= 0; i--) {
+		T sum = 0;
+		for (int k = row_starts[i + 1] - 1; k >= row_starts[i] && columns[k] > i; k--)
+			sum = sum + values[k] * z[columns[k]];
+		z[i] = z[i] - _relaxation * sum / _diagonal[i];
+	}
+	for (int i = 0; i < size; i++)
+		z[i] = _scale * z[i];
+}
@@ -0,0 +1,237 @@
+// SparseMatrix.h
+// Defines the SparseMatrix<T> type, a matrix stored in the compressed sparse row (CSR) format
+// Only nonzero elements are stored: values and column indices of all elements row by row, and the position where each row starts
+// Column indices inside a row are sorted and unique, which the triangular solves rely on
+// Provides sparse matrix-vector products (parallel for large matrices) and triangular solves with the lower or upper part of the matrix
+
+#pragma once
+#include<vector>
+#include<numeric>
+#include<algorithm>
+#include<iostream>
+
+#include "Matrix.h"
+#include "thread_pool.h"
+
+template<Numerical T>
+class SparseMatrix {
+public:
+	SparseMatrix() : _row_count(0), _column_count(0), _row_starts(1, 0) {}
+	SparseMatrix(int row_count, int column_count) : _row_count(row_count), _column_count(column_count), _row_starts(row_count + 1, 0) {}
+	// takes arrays already in the CSR format (sorted unique columns in every row)
+	SparseMatrix(int row_count, int column_count, std::vector<int> row_starts, std::vector<int> column_indices, std::vector<T> values);
+
+	// builds the matrix from (row, column, value) triplets in any order, values of duplicate positions are summed
+	static SparseMatrix<T> from_triplets(int row_count, int column_count, const std::vector<int>& rows, const std::vector<int>& columns, const std::vector<T>& values);
+	static SparseMatrix<T> from_dense(const Matrix<T>& matrix);
+	Matrix<T> to_dense() const;
+
+	int get_row_count() const { return _row_count; }
+	int get_column_count() const { return _column_count; }
+	int get_nonzero_count() const { return static_cast<int>(_values.size()); }
+	bool is_square() const { return _row_count == _column_count; }
+
+	const std::vector<int>& get_row_starts() const { return _row_starts; }
+	const std::vector<int>& get_column_indices() const { return _column_indices; }
+	const std::vector<T>& get_values() const { return _values; }
+	// values can be changed in place, the sparsity pattern stays the same
+	std::vector<T>& get_values() { return _values; }
+
+	// returns the element at given position, zero if it is not stored
+	T get_value(int row, int column) const;
+	// returns the index of the element in the values array, -1 if it is not stored
+	int find(int row, int column) const;
+
+	// y = A * x, x has column_count and y row_count elements
+	void multiply(const T* x, T* y) const;
+	// product with a dense matrix (a vector is a matrix with one column)
+	Matrix<T> operator*(const Matrix<T>& x) const;
+
+	// solves L * x = b where L is the lower triangle of the matrix (with unit_diagonal the stored diagonal is ignored and taken as ones)
+	void solve_lower(const T* b, T* x, bool unit_diagonal = false) const;
+	// solves U * x = b where U is the upper triangle of the matrix
+	void solve_upper(const T* b, T* x, bool unit_diagonal = false) const;
+
+	void print(std::ostream& stream = std::cout) const;
+
+	// rows multiplied by one thread in parallel products
+	static inline int parallel_rows = 4096;
+
+private:
+	T diagonal_value(int row) const;
+
+	int _row_count;
+	int _column_count;
+	std::vector<int> _row_starts;
+	std::vector<int> _column_indices;
+	std::vector<T> _values;
+};
+
+template<Numerical T>
+SparseMatrix<T>::SparseMatrix(int row_count, int column_count, std::vector<int> row_starts, std::vector<int> column_indices, std::vector<T> values)
+	: _row_count(row_count), _column_count(column_count), _row_starts(std::move(row_starts)), _column_indices(std::move(column_indices)), _values(std::move(values))
+{
+	if (_row_starts.size() != static_cast<size_t>(row_count) + 1 || _column_indices.size() != _values.size() || _row_starts.back() != static_cast<int>(_values.size()))
+		throw MatrixException("Error: invalid CSR format of sparse matrix");
+}
+
+// Builds CSR from triplets in O(nonzeros) memory: rows are bucketed by a counting sort,
+// then every row is sorted by column and duplicates are merged
+template<Numerical T>
+SparseMatrix<T> SparseMatrix<T>::from_triplets(int row_count, int column_count, const std::vector<int>& rows, const std::vector<int>& columns, const std::vector<T>& values)
+{
+	SparseMatrix<T> matrix(row_count, column_count);
+	size_t count = values.size();
+	for (size_t i = 0; i < count; i++) {
+		if (rows[i] < 0 || rows[i] >= row_count || columns[i] < 0 || columns[i] >= column_count)
+			throw MatrixException("Error: sparse matrix element out of range");
+		matrix._row_starts[rows[i] + 1]++;
+	}
+	std::partial_sum(matrix._row_starts.begin(), matrix._row_starts.end(), matrix._row_starts.begin());
+
+	std::vector<int> next(matrix._row_starts.begin(), matrix._row_starts.end() - 1);
+	std::vector<std::pair<int, T>> entries(count);
+	for (size_t i = 0; i < count; i++)
+		entries[next[rows[i]]++] = { columns[i], values[i] };
+
+	matrix._column_indices.reserve(count);
+	matrix._values.reserve(count);
+	int written = 0;
+	for (int row = 0; row < row_count; row++) {
+		auto begin = entries.begin() + matrix._row_starts[row];
+		auto end = entries.begin() + matrix._row_starts[row + 1];
+		std::sort(begin, end, [](const std::pair<int, T>& a, const std::pair<int, T>& b) { return a.first < b.first; });
+		matrix._row_starts[row] = written;
+		for (auto it = begin; it != end; ++it) {
+			if (written > matrix._row_starts[row] && matrix._column_indices.back() == it->first) {
+				matrix._values.back() = matrix._values.back() + it->second;
+				continue;
+			}
+			matrix._column_indices.push_back(it->first);
+			matrix._values.push_back(it->second);
+			written++;
+		}
+	}
+	matrix._row_starts[row_count] = written;
+	return matrix;
+}
+
+template<Numerical T>
+SparseMatrix<T> SparseMatrix<T>::from_dense(const Matrix<T>& matrix)
+{
+	SparseMatrix<T> sparse(matrix.get_row_count(), matrix.get_column_count());
+	for (int i = 0; i < matrix.get_row_count(); i++) {
+		for (int j = 0; j < matrix.get_column_count(); j++) {
+			T value = matrix(i, j);
+			if (value == 0)
+				continue;
+			sparse._column_indices.push_back(j);
+			sparse._values.push_back(value);
+		}
+		sparse._row_starts[i + 1] = static_cast<int>(sparse._values.size());
+	}
+	return sparse;
+}
+
+template<Numerical T>
+Matrix<T> SparseMatrix<T>::to_dense() const
+{
+	Matrix<T> dense(_row_count, _column_count);
+	for (int i = 0; i < _row_count; i++)
+		for (int k = _row_starts[i]; k < _row_starts[i + 1]; k++)
+			dense(i, _column_indices[k]) = _values[k];
+	return dense;
+}
+
+template<Numerical T>
+int SparseMatrix<T>::find(int row, int column) const
+{
+	auto begin = _column_indices.begin() + _row_starts[row];
+	auto end = _column_indices.begin() + _row_starts[row + 1];
+	auto it = std::lower_bound(begin, end, column);
+	return it != end && *it == column ? static_cast<int>(it - _column_indices.begin()) : -1;
+}
+
+template<Numerical T>
+T SparseMatrix<T>::get_value(int row, int column) const
+{
+	int idx = find(row, column);
+	return idx < 0 ? T(0) : _values[idx];
+}
+
+// Rows are independent, large matrices are split into blocks of parallel_rows rows multiplied by the ThreadPool
+template<Numerical T>
+void SparseMatrix<T>::multiply(const T* x, T* y) const
+{
+	auto multiply_rows = [&](int block) {
+		int first = block * parallel_rows;
+		int last = std::min(first + parallel_rows, _row_count);
+		for (int i = first; i < last; i++) {
+			int start = _row_starts[i];
+			y[i] = VectorKernels<T>::sparse_dot(_row_starts[i + 1] - start, _values.data() + start, _column_indices.data() + start, x);
+		}
+	};
+	int block_count = (_row_count + parallel_rows - 1) / parallel_rows;
+	ThreadPool::instance().parallel_for(0, block_count, multiply_rows);
+}
+
+template<Numerical T>
+Matrix<T> SparseMatrix<T>::operator*(const Matrix<T>& x) const
+{
+	if (x.get_row_count() != _column_count)
+		throw MatrixException("Error when multiplying matricies: incompatible dimensions.");
+
+	int column_count = x.get_column_count();
+	Matrix<T> product(_row_count, column_count);
+	if (column_count == 1) {
+		multiply(x.data(), product.data());
+		return product;
+	}
+	for (int i = 0; i < _row_count; i++)
+		for (int k = _row_starts[i]; k < _row_starts[i + 1]; k++)
+			VectorKernels<T>::axpy(column_count, _values[k], x[_column_indices[k]], product[i]);
+	return product;
+}
+
+template<Numerical T>
+T SparseMatrix<T>::diagonal_value(int row) const
+{
+	T diagonal = get_value(row, row);
+	if (diagonal == 0)
+		throw SystemSolverException("Error: cannot compute sparse triangular solve, zero on the matrixs diagonal");
+	return diagonal;
+}
+
+// Forward substitution, only the elements left of the diagonal are used
+template<Numerical T>
+void SparseMatrix<T>::solve_lower(const T* b, T* x, bool unit_diagonal) const
+{
+	for (int i = 0; i < _row_count; i++) {
+		T sum = 0;
+		for (int k = _row_starts[i]; k < _row_starts[i + 1] && _column_indices[k] < i; k++)
+			sum = sum + _values[k] * x[_column_indices[k]];
+		x[i] = unit_diagonal ? b[i] - sum : (b[i] - sum) / diagonal_value(i);
+	}
+}
+
+// Backward substitution, only the elements right of the diagonal are used
+template<Numerical T>
+void SparseMatrix<T>::solve_upper(const T* b, T* x, bool unit_diagonal) const
+{
+	for (int i = _row_count - 1; i >= 0; i--) {
+		T sum = 0;
+		for (int k = _row_starts[i + 1] - 1; k >= _row_starts[i] && _column_indices[k] > i; k--)
+			sum = sum + _values[k] * x[_column_indices[k]];
+		x[i] = unit_diagonal ? b[i] - sum : (b[i] - sum) / diagonal_value(i);
+	}
+}
+
+// prints the matrix in the compact format of matrix_loader::load_compact
+template<Numerical T>
+void SparseMatrix<T>::print(std::ostream& stream) const
+{
+	stream << _row_count << " " << _column_count << " " << get_nonzero_count() << std::endl;
+	for (int i = 0; i < _row_count; i++)
+		for (int k = _row_starts[i]; k < _row_starts[i + 1]; k++)
+			stream << i << " " << _column_indices[k] << " " << _values[k] << std::endl;
+}
@@ -0,0 +1,107 @@
+// SplitComplexMatrix.h
+// Defines the SplitComplexMatrix type, a matrix of std::complex<double> stored in the split (structure of arrays) layout:
+// one Matrix<double> holds the real parts and another one the imaginary parts of all elements
+// SIMD registers then hold only real or only imaginary parts, so a complex multiply-add is four fused multiply-adds
+// without the shuffles of interleaved std::complex<double> (SplitComplexKernels in simd_kernels.h),
+// and a product of complex matrices is four products of real matrices done by the double Gemm kernels
+// LinSolver::solve_lu converts complex<double> systems to this layout, LinSolver::LU_factorize and LU_solve work on it directly
+
+#pragma once
+#include<complex>
+#include<iostream>
+#include<algorithm>
+
+#include "Matrix.h"
+#include "gemm.h"
+#include "simd_kernels.h"
+
+class SplitComplexMatrix {
+public:
+	using Complex = std::complex<double>;
+
+	SplitComplexMatrix() = default;
+	SplitComplexMatrix(int row_count, int column_count) : _real(row_count, column_count), _imag(row_count, column_count) {}
+	explicit SplitComplexMatrix(const MatrixView<const Complex>& matrix);
+	explicit SplitComplexMatrix(const Matrix<Complex>& matrix) : SplitComplexMatrix(matrix.get_view()) {}
+	Matrix<Complex> to_complex() const;
+
+	int get_row_count() const { return _real.get_row_count(); }
+	int get_column_count() const { return _real.get_column_count(); }
+	bool is_square() const { return _real.is_square(); }
+
+	Complex get_value(int i, int j) const { return Complex(_real[i][j], _imag[i][j]); }
+	void set_value(int i, int j, const Complex value) {
+		_real[i][j] = value.real();
+		_imag[i][j] = value.imag();
+	}
+	// |element|^2, the key of partial pivoting
+	double norm(int i, int j) const { return _real[i][j] * _real[i][j] + _imag[i][j] * _imag[i][j]; }
+
+	// planes of real and imaginary parts
+	Matrix<double>& get_real() { return _real; }
+	const Matrix<double>& get_real() const { return _real; }
+	Matrix<double>& get_imag() { return _imag; }
+	const Matrix<double>& get_imag() const { return _imag; }
+
+	void swap_rows(int i, int j);
+	SplitComplexMatrix operator*(const SplitComplexMatrix& other) const;
+
+	// C = alpha * A * B + beta * C on planes of matrices (or submatrices), alpha and beta are real
+	// Computed as C_re = alpha * (A_re * B_re - A_im * B_im) + beta * C_re, C_im = alpha * (A_re * B_im + A_im * B_re) + beta * C_im
+	static void multiply(const MatrixView<const double>& a_real, const MatrixView<const double>& a_imag,
+		const MatrixView<const double>& b_real, const MatrixView<const double>& b_imag,
+		const MatrixView<double>& c_real, const MatrixView<double>& c_imag, const double alpha = 1, const double beta = 0);
+
+	void print(std::ostream& stream = std::cout) const { to_complex().print(stream); }
+
+private:
+	Matrix<double> _real;
+	Matrix<double> _imag;
+};
+
+inline SplitComplexMatrix::SplitComplexMatrix(const MatrixView<const Complex>& matrix)
+	: _real(matrix.get_row_count(), matrix.get_column_count()), _imag(matrix.get_row_count(), matrix.get_column_count())
+{
+	for (int i = 0; i < matrix.get_row_count(); i++)
+		for (int j = 0; j < matrix.get_column_count(); j++) {
+			_real[i][j] = matrix[i][j].real();
+			_imag[i][j] = matrix[i][j].imag();
+		}
+}
+
+inline Matrix<SplitComplexMatrix::Complex> SplitComplexMatrix::to_complex() const
+{
+	Matrix<Complex> matrix(get_row_count(), get_column_count());
+	for (int i = 0; i < get_row_count(); i++)
+		for (int j = 0; j < get_column_count(); j++)
+			matrix[i][j] = get_value(i, j);
+	return matrix;
+}
+
+inline void SplitComplexMatrix::swap_rows(int i, int j)
+{
+	if (i == j)
+		return;
+	int column_count = get_column_count();
+	std::swap_ranges(_real[i], _real[i] + column_count, _real[j]);
+	std::swap_ranges(_imag[i], _imag[i] + column_count, _imag[j]);
+}
+
+inline SplitComplexMatrix SplitComplexMatrix::operator*(const SplitComplexMatrix& other) const
+{
+	if (get_column_count() != other.get_row_count())
+		throw MatrixException("Error when multiplying matricies: incompatible dimensions.");
+	SplitComplexMatrix product(get_row_count(), other.get_column_count());
+	multiply(_real.get_view(), _imag.get_view(), other._real.get_view(), other._imag.get_view(), product._real.get_view(), product._imag.get_view());
+	return product;
+}
+
+inline void SplitComplexMatrix::multiply(const MatrixView<const double>& a_real, const MatrixView<const double>& a_imag,
+	const MatrixView<const double>& b_real, const MatrixView<const double>& b_imag,
+	const MatrixView<double>& c_real, const MatrixView<double>& c_imag, const double alpha, const double beta)
+{
+	Gemm::multiply<double>(a_real, false, b_real, false, c_real, alpha, beta);
+	Gemm::multiply<double>(a_imag, false, b_imag, false, c_real, -alpha, 1);
+	Gemm::multiply<double>(a_real, false, b_imag, false, c_imag, alpha, beta);
+	Gemm::multiply<double>(a_imag, false, b_real, false, c_imag, alpha, 1);
+}
@@ -0,0 +1,178 @@
+// WiedemannSolver.h
+// Wiedemann's black box solver for large sparse systems over FiniteGroup<N> with a prime modulus N
+// Gaussian elimination fills in a sparse matrix and needs O(n^2) memory and O(n^3) time, Wiedemann's method only multiplies
+// the matrix by vectors (any LinearOperator of IterativeSolver.h, a SparseMatrix multiplies in parallel) and keeps a few vectors:
+// the scalar sequence u * A^i * b for a random vector u is generated, the Berlekamp-Massey algorithm finds its minimal polynomial f
+// and x = -(f_1 * b + f_2 * A * b + ... + f_L * A^(L-1) * b) / f_0 is computed by a second pass over the same Krylov vectors
+// A random u may give only a factor of the minimal polynomial of b, then the residual b - A * x is solved in the same way
+// (its minimal polynomial is the remaining factor), so every solve is checked and the result is exact
+// The sequence is stopped early when the Berlekamp-Massey algorithm did not find a longer recurrence for a number of steps,
+// the residual check catches the rare early stops that were wrong
+// A zero constant coefficient f_0 of the polynomial of the full sequence (2n elements) proves that the matrix is singular
+// (a singular system can still be solved when the sequence of b does not reveal it, the returned x then satisfies A * x = b)
+
+#pragma once
+#include<vector>
+#include<random>
+#include<limits>
+#include<algorithm>
+
+#include "Matrix.h"
+#include "number_types.h"
+#include "IterativeSolver.h"
+
+class WiedemannSolver {
+public:
+	// solves A * x = b, b has one column and a is a square operator (SparseMatrix<FiniteGroup<N>> or Matrix<FiniteGroup<N>>)
+	template<unsigned long long N, LinearOperator<FiniteGroup<N>> Operator>
+	static Matrix<FiniteGroup<N>> solve(const Operator& a, const Matrix<FiniteGroup<N>>& b);
+
+	// steps without a change of the recurrence after which the sequence is considered complete
+	static inline int early_termination = 16;
+	// rounds (random projections) after which the solve fails, usually one or two are needed
+	static inline int max_rounds = 16;
+	static inline unsigned long long random_seed = 0x5DEECE66Dull;
+
+private:
+	// Berlekamp-Massey algorithm fed one element of the sequence at a time
+	// connection holds c_0 = 1, c_1, ... with c_0 * s_i + c_1 * s_(i-1) + ... + c_L * s_(i-L) = 0 for all elements so far
+	// The sequence is stored from the end of the buffer backwards, so the discrepancy is a contiguous dot product with the connection
+	template<typename T>
+	struct BerlekampMassey {
+		explicit BerlekampMassey(const int capacity) : reversed(capacity), position(capacity) {}
+
+		std::vector<T> reversed;
+		int position;
+		std::vector<T> connection{ T(1) };
+		std::vector<T> previous{ T(1) };
+		T previous_discrepancy = T(1);
+		int length = 0;
+		int shift = 1;
+		int unchanged = 0;
+
+		void add(const T value);
+		// coefficients f_0 ... f_L of the minimal polynomial z^L * C(1/z), f_L = 1
+		std::vector<T> minimal_polynomial() const;
+		T constant_coefficient() const { return length < static_cast<int>(connection.size()) ? connection[length] : T(0); }
+	};
+
+	// one round of Wiedemann's method for the right side b, adds the solution to x; returns false if the projection found nothing
+	template<typename T, typename Operator>
+	static bool solve_round(const Operator& a, const std::vector<T>& b, std::vector<T>& x, std::mt19937_64& generator);
+};
+
+template<unsigned long long N, LinearOperator<FiniteGroup<N>> Operator>
+Matrix<FiniteGroup<N>> WiedemannSolver::solve(const Operator& a, const Matrix<FiniteGroup<N>>& b)
+{
+	using T = FiniteGroup<N>;
+	const int size = a.get_row_count();
+	if (b.get_row_count() != size || b.get_column_count() != 1)
+		throw SystemSolverException("Error: right side has to be a vector with one element per row of the matrix");
+
+	std::mt19937_64 generator(random_seed);
+	std::vector<T> x(size), residual(b.data(), b.data() + size), product(size);
+	for (int round = 0; std::any_of(residual.begin(), residual.end(), [](const T value) { return !(value == 0); }); round++) {
+		if (round == max_rounds)
+			throw SystemSolverException("Error: cannot solve system, Wiedemann's method did not converge");
+		std::vector<T> correction(size);
+		if (!solve_round(a, residual, correction, generator))
+			continue;
+		VectorKernels<T>::axpy(size, T(1), correction.data(), x.data());
+
+		// residual = b - A * x, its minimal polynomial divides the one of the previous residual
+		a.multiply(x.data(), product.data());
+		for (int i = 0; i < size; i++)
+			residual[i] = b(i) - product[i];
+	}
+
+	Matrix<T> result(size, 1);
+	std::copy(x.begin(), x.end(), result.data());
+	return result;
+}
+
+// The Krylov vectors A^i * b are not stored, the second pass recomputes them, so the memory does not grow with the length of the sequence
+template<typename T, typename Operator>
+bool WiedemannSolver::solve_round(const Operator& a, const std::vector<T>& b, std::vector<T>& x, std::mt19937_64& generator)
+{
+	const int size = static_cast<int>(b.size());
+	std::uniform_int_distribution<long long> distribution(0, std::numeric_limits<long long>::max());
+	std::vector<T> u(size);
+	for (T& value : u)
+		value = T(distribution(generator));
+
+	BerlekampMassey<T> recurrence(2 * size);
+	std::vector<T> krylov(b), next(size);
+	for (int i = 0; i < 2 * size; i++) {
+		recurrence.add(VectorKernels<T>::dot(size, u.data(), krylov.data()));
+		// a polynomial divisible by z is only trusted for the full sequence
+		if (recurrence.unchanged >= early_termination && i >= 2 * recurrence.length && !(recurrence.constant_coefficient() == 0))
+			break;
+		if (i + 1 < 2 * size) {
+			a.multiply(krylov.data(), next.data());
+			std::swap(krylov, next);
+		}
+	}
+	if (recurrence.length == 0)
+		return false;
+
+	std::vector<T> polynomial = recurrence.minimal_polynomial();
+	if (polynomial[0] == 0)
+		throw SystemSolverException("Error: cannot solve system, matrix is singular");
+
+	// x = -(f_1 * b + f_2 * A * b + ... + f_L * A^(L-1) * b) / f_0
+	T scale = -polynomial[0].inverse();
+	krylov = b;
+	for (int k = 1; k <= recurrence.length; k++) {
+		VectorKernels<T>::axpy(size, polynomial[k] * scale, krylov.data(), x.data());
+		if (k < recurrence.length) {
+			a.multiply(krylov.data(), next.data());
+			std::swap(krylov, next);
+		}
+	}
+	return true;
+}
+
+template<typename T>
+void WiedemannSolver::BerlekampMassey<T>::add(const T value)
+{
+	reversed[--position] = value;
+	const int i = static_cast<int>(reversed.size()) - 1 - position;
+	// s_(i-j) = reversed[position + j]
+	int terms = std::min(length, static_cast<int>(connection.size()) - 1);
+	T discrepancy = value + VectorKernels<T>::dot(terms, connection.data() + 1, reversed.data() + position + 1);
+	if (discrepancy == 0) {
+		shift++;
+		unchanged++;
+		return;
+	}
+
+	// connection = connection - discrepancy / previous_discrepancy * z^shift * previous
+	T factor = discrepancy * previous_discrepancy.inverse();
+	std::vector<T> old_connection;
+	bool longer = 2 * length <= i;
+	if (longer)
+		old_connection = connection;
+	if (connection.size() < previous.size() + shift)
+		connection.resize(previous.size() + shift);
+	VectorKernels<T>::axpy(static_cast<int>(previous.size()), -factor, previous.data(), connection.data() + shift);
+
+	if (longer) {
+		previous = std::move(old_connection);
+		previous_discrepancy = discrepancy;
+		length = i + 1 - length;
+		shift = 1;
+	}
+	else
+		shift++;
+	unchanged = 0;
+}
+
+template<typename T>
+std::vector<T> WiedemannSolver::BerlekampMassey<T>::minimal_polynomial() const
+{
+	std::vector<T> polynomial(length + 1);
+	for (int k = 0; k < length && length - k < static_cast<int>(connection.size()); k++)
+		polynomial[k] = connection[length - k];
+	polynomial[length] = connection[0];
+	return polynomial;
+}
@@ -0,0 +1,98 @@
+// checked_arithmetic.h
+// Integer arithmetic that reports overflow instead of silently wrapping around, used by the exact solvers (ExactSolver.h)
+// Every function returns false when the exact result does not fit into the result type, the result is then left unspecified
+// With GCC and Clang the checks are the overflow flag of the instruction (__builtin_*_overflow) and WideInt is a 128-bit integer,
+// so products of two 64-bit numbers are formed exactly; other compilers use portable range checks and a 64-bit WideInt
+
+#pragma once
+#include<limits>
+#include<utility>
+#include<concepts>
+
+#if defined(__SIZEOF_INT128__)
+#define LINSOLVE_INT128
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LINSOLVE_OVERFLOW_BUILTINS
+#endif
+
+class CheckedArithmetic {
+public:
+#ifdef LINSOLVE_INT128
+	using WideInt = __int128;
+#else
+	using WideInt = long long;
+#endif
+
+	template<typename I>
+	static constexpr bool add(const I a, const I b, I& result) {
+#ifdef LINSOLVE_OVERFLOW_BUILTINS
+		return !__builtin_add_overflow(a, b, &result);
+#else
+		if ((b > 0 && a > std::numeric_limits<I>::max() - b) || (b < 0 && a < std::numeric_limits<I>::min() - b))
+			return false;
+		result = a + b;
+		return true;
+#endif
+	}
+
+	template<typename I>
+	static constexpr bool subtract(const I a, const I b, I& result) {
+#ifdef LINSOLVE_OVERFLOW_BUILTINS
+		return !__builtin_sub_overflow(a, b, &result);
+#else
+		if ((b < 0 && a > std::numeric_limits<I>::max() + b) || (b > 0 && a < std::numeric_limits<I>::min() + b))
+			return false;
+		result = a - b;
+		return true;
+#endif
+	}
+
+	template<typename I>
+	static constexpr bool multiply(const I a, const I b, I& result) {
+#ifdef LINSOLVE_OVERFLOW_BUILTINS
+		return !__builtin_mul_overflow(a, b, &result);
+#else
+		constexpr I max = std::numeric_limits<I>::max(), min = std::numeric_limits<I>::min();
+		if (a > 0 ? (b > 0 ? a > max / b : b < min / a) : (b > 0 ? a < min / b : a != 0 && b < max / a))
+			return false;
+		result = a * b;
+		return true;
+#endif
+	}
+
+	// result = value converted to the narrower type I
+	template<typename I, typename W>
+	static constexpr bool narrow(const W value, I& result) {
+		// std::in_range compares mixed signed and unsigned types correctly, but is defined only for the standard integer types
+		if constexpr (std::integral<W>) {
+			if (!std::in_range<I>(value))
+				return false;
+		}
+		else if (value < static_cast<W>(std::numeric_limits<I>::min()) || value > static_cast<W>(std::numeric_limits<I>::max()))
+			return false;
+		result = static_cast<I>(value);
+		return true;
+	}
+
+	// result = (a * b - c * d) / divisor, the division has to be exact (the elimination step of the Bareiss algorithm)
+	// The products are formed in WideInt, so only the quotient has to fit into long long when WideInt has 128 bits
+	static constexpr bool multiply_subtract_divide(const long long a, const long long b, const long long c, const long long d, const long long divisor, long long& result) {
+		WideInt ab = 0, cd = 0, difference = 0;
+		if (!multiply<WideInt>(a, b, ab) || !multiply<WideInt>(c, d, cd) || !subtract(ab, cd, difference))
+			return false;
+		return narrow(difference / divisor, result);
+	}
+
+	// greatest common divisor of two non-negative values
+	template<typename I>
+	static constexpr I gcd(I a, I b) {
+		while (b != 0) {
+			I remainder = a % b;
+			a = b;
+			b = remainder;
+		}
+		return a;
+	}
+};
@@ -1,7 +1,7 @@
 #include<complex>
 
 auto operator<=> (const std::complex<double> left, const std::complex<double> right) {
-	return abs(left) <=> abs(right);
+	return std::norm(left) <=> std::norm(right);
 }
 bool operator== (const std::complex<double> left, const int right) {
 	return left.real() == right && left.imag() == 0;
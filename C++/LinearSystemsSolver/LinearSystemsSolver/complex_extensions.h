@@ -4,12 +4,13 @@
 // Implements comparison and equality operators for complex numbers
 // Needed for the complex<double> type to be compatible with the Numerical concept
 // Note that complex numbers are not ordered and in this project are compared by their absolute value, which works well with pivoting in LU decomposition
+// The squared magnitudes are compared, they are ordered the same way as the absolute values and need no square root
 
 #include<complex>
 
-auto operator<=> (const std::complex<double> left, const std::complex<double> right) {
-	return abs(left) <=> abs(right);
+inline auto operator<=> (const std::complex<double> left, const std::complex<double> right) {
+	return std::norm(left) <=> std::norm(right);
 }
-bool operator== (const std::complex<double> left, const int right) {
+inline bool operator== (const std::complex<double> left, const int right) {
 	return left.real() == right && left.imag() == 0;
 }
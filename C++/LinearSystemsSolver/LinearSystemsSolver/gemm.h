@@ -0,0 +1,402 @@
+// gemm.h
+// Cache blocked, multithreaded general matrix multiplication C = alpha * op(A) * op(B) + beta * C used behind Matrix<T>::operator*
+// T is any Numerical type, the kernels only use +, *, T(int) and comparison with int
+//
+// The product is computed in three levels of blocking:
+// - columns of B and C are split into blocks of block_columns, the inner dimension into blocks of block_depth
+// - each block of B is packed into a contiguous buffer of register_columns wide panels, shared by all threads
+// - rows of A and C are split into blocks of block_rows which are distributed among the threads of the ThreadPool,
+//   every thread packs its block of A into register_rows tall panels and multiplies it with all the panels of B
+// The innermost micro kernel keeps a register_rows x register_columns block of C in local accumulators
+// Fast paths for double, float and std::complex<double> are specializations of GemmMicroKernel,
+// the double and float kernels use AVX2 / AVX-512 when the CPU supports it (dispatched as in simd_kernels.h)
+
+#pragma once
+#include<vector>
+#include<complex>
+#include<algorithm>
+
+#include "MatrixView.h"
+#include "thread_pool.h"
+#include "simd_kernels.h"
+
+// Size of the block of C kept in registers by the micro kernel
+template<typename T>
+struct GemmRegisterBlock {
+	static constexpr int rows = 4;
+	static constexpr int columns = 4;
+};
+
+template<>
+struct GemmRegisterBlock<double> {
+	static constexpr int rows = 6;
+	static constexpr int columns = 8;
+};
+
+template<>
+struct GemmRegisterBlock<float> {
+	static constexpr int rows = 6;
+	static constexpr int columns = 16;
+};
+
+template<>
+struct GemmRegisterBlock<std::complex<double>> {
+	static constexpr int rows = 2;
+	static constexpr int columns = 4;
+};
+
+// Computes the register block of C from a packed panel of A (depth x rows, column by column) and a packed panel of B (depth x columns, row by row)
+// Only the first row_count x column_count part of the block is written back (panels at the edges are padded with zeros)
+template<typename T>
+struct GemmMicroKernel {
+	static constexpr int MR = GemmRegisterBlock<T>::rows;
+	static constexpr int NR = GemmRegisterBlock<T>::columns;
+
+	static void run(int depth, const T* a, const T* b, T* c, int ldc, int row_count, int column_count, T alpha, bool alpha_is_one) {
+		T acc[MR][NR];
+		for (int i = 0; i < MR; i++)
+			for (int j = 0; j < NR; j++)
+				acc[i][j] = T(0);
+
+		for (int p = 0; p < depth; p++, a += MR, b += NR)
+			for (int i = 0; i < MR; i++)
+				for (int j = 0; j < NR; j++)
+					acc[i][j] = acc[i][j] + a[i] * b[j];
+
+		for (int i = 0; i < row_count; i++)
+			for (int j = 0; j < column_count; j++)
+				c[i * ldc + j] = c[i * ldc + j] + (alpha_is_one ? acc[i][j] : alpha * acc[i][j]);
+	}
+};
+
+#ifdef LINSOLVE_X86_SIMD
+namespace simd_detail {
+	// 6 x 8 block of doubles: two AVX2 registers per row, 12 accumulators
+	LINSOLVE_TARGET_AVX2 inline void gemm_6x8_avx2(int depth, const double* a, const double* b, double* acc) {
+		__m256d c00 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+		__m256d c20 = _mm256_setzero_pd(), c21 = _mm256_setzero_pd(), c30 = _mm256_setzero_pd(), c31 = _mm256_setzero_pd();
+		__m256d c40 = _mm256_setzero_pd(), c41 = _mm256_setzero_pd(), c50 = _mm256_setzero_pd(), c51 = _mm256_setzero_pd();
+		for (int p = 0; p < depth; p++, a += 6, b += 8) {
+			__m256d b0 = _mm256_loadu_pd(b);
+			__m256d b1 = _mm256_loadu_pd(b + 4);
+			__m256d ai = _mm256_broadcast_sd(a);
+			c00 = _mm256_fmadd_pd(ai, b0, c00); c01 = _mm256_fmadd_pd(ai, b1, c01);
+			ai = _mm256_broadcast_sd(a + 1);
+			c10 = _mm256_fmadd_pd(ai, b0, c10); c11 = _mm256_fmadd_pd(ai, b1, c11);
+			ai = _mm256_broadcast_sd(a + 2);
+			c20 = _mm256_fmadd_pd(ai, b0, c20); c21 = _mm256_fmadd_pd(ai, b1, c21);
+			ai = _mm256_broadcast_sd(a + 3);
+			c30 = _mm256_fmadd_pd(ai, b0, c30); c31 = _mm256_fmadd_pd(ai, b1, c31);
+			ai = _mm256_broadcast_sd(a + 4);
+			c40 = _mm256_fmadd_pd(ai, b0, c40); c41 = _mm256_fmadd_pd(ai, b1, c41);
+			ai = _mm256_broadcast_sd(a + 5);
+			c50 = _mm256_fmadd_pd(ai, b0, c50); c51 = _mm256_fmadd_pd(ai, b1, c51);
+		}
+		_mm256_storeu_pd(acc, c00); _mm256_storeu_pd(acc + 4, c01);
+		_mm256_storeu_pd(acc + 8, c10); _mm256_storeu_pd(acc + 12, c11);
+		_mm256_storeu_pd(acc + 16, c20); _mm256_storeu_pd(acc + 20, c21);
+		_mm256_storeu_pd(acc + 24, c30); _mm256_storeu_pd(acc + 28, c31);
+		_mm256_storeu_pd(acc + 32, c40); _mm256_storeu_pd(acc + 36, c41);
+		_mm256_storeu_pd(acc + 40, c50); _mm256_storeu_pd(acc + 44, c51);
+	}
+
+	// 6 x 8 block of doubles: one AVX-512 register per row
+	LINSOLVE_TARGET_AVX512 inline void gemm_6x8_avx512(int depth, const double* a, const double* b, double* acc) {
+		__m512d c0 = _mm512_setzero_pd(), c1 = _mm512_setzero_pd(), c2 = _mm512_setzero_pd();
+		__m512d c3 = _mm512_setzero_pd(), c4 = _mm512_setzero_pd(), c5 = _mm512_setzero_pd();
+		for (int p = 0; p < depth; p++, a += 6, b += 8) {
+			__m512d vb = _mm512_loadu_pd(b);
+			c0 = _mm512_fmadd_pd(_mm512_set1_pd(a[0]), vb, c0);
+			c1 = _mm512_fmadd_pd(_mm512_set1_pd(a[1]), vb, c1);
+			c2 = _mm512_fmadd_pd(_mm512_set1_pd(a[2]), vb, c2);
+			c3 = _mm512_fmadd_pd(_mm512_set1_pd(a[3]), vb, c3);
+			c4 = _mm512_fmadd_pd(_mm512_set1_pd(a[4]), vb, c4);
+			c5 = _mm512_fmadd_pd(_mm512_set1_pd(a[5]), vb, c5);
+		}
+		_mm512_storeu_pd(acc, c0); _mm512_storeu_pd(acc + 8, c1); _mm512_storeu_pd(acc + 16, c2);
+		_mm512_storeu_pd(acc + 24, c3); _mm512_storeu_pd(acc + 32, c4); _mm512_storeu_pd(acc + 40, c5);
+	}
+
+	// 6 x 16 block of floats: two AVX2 registers per row, 12 accumulators
+	LINSOLVE_TARGET_AVX2 inline void gemm_6x16_avx2(int depth, const float* a, const float* b, float* acc) {
+		__m256 c[6][2];
+		for (int i = 0; i < 6; i++)
+			c[i][0] = c[i][1] = _mm256_setzero_ps();
+		for (int p = 0; p < depth; p++, a += 6, b += 16) {
+			__m256 b0 = _mm256_loadu_ps(b);
+			__m256 b1 = _mm256_loadu_ps(b + 8);
+			for (int i = 0; i < 6; i++) {
+				__m256 ai = _mm256_broadcast_ss(a + i);
+				c[i][0] = _mm256_fmadd_ps(ai, b0, c[i][0]);
+				c[i][1] = _mm256_fmadd_ps(ai, b1, c[i][1]);
+			}
+		}
+		for (int i = 0; i < 6; i++) {
+			_mm256_storeu_ps(acc + 16 * i, c[i][0]);
+			_mm256_storeu_ps(acc + 16 * i + 8, c[i][1]);
+		}
+	}
+
+	// 6 x 16 block of floats: one AVX-512 register per row
+	LINSOLVE_TARGET_AVX512 inline void gemm_6x16_avx512(int depth, const float* a, const float* b, float* acc) {
+		__m512 c0 = _mm512_setzero_ps(), c1 = _mm512_setzero_ps(), c2 = _mm512_setzero_ps();
+		__m512 c3 = _mm512_setzero_ps(), c4 = _mm512_setzero_ps(), c5 = _mm512_setzero_ps();
+		for (int p = 0; p < depth; p++, a += 6, b += 16) {
+			__m512 vb = _mm512_loadu_ps(b);
+			c0 = _mm512_fmadd_ps(_mm512_set1_ps(a[0]), vb, c0);
+			c1 = _mm512_fmadd_ps(_mm512_set1_ps(a[1]), vb, c1);
+			c2 = _mm512_fmadd_ps(_mm512_set1_ps(a[2]), vb, c2);
+			c3 = _mm512_fmadd_ps(_mm512_set1_ps(a[3]), vb, c3);
+			c4 = _mm512_fmadd_ps(_mm512_set1_ps(a[4]), vb, c4);
+			c5 = _mm512_fmadd_ps(_mm512_set1_ps(a[5]), vb, c5);
+		}
+		_mm512_storeu_ps(acc, c0); _mm512_storeu_ps(acc + 16, c1); _mm512_storeu_ps(acc + 32, c2);
+		_mm512_storeu_ps(acc + 48, c3); _mm512_storeu_ps(acc + 64, c4); _mm512_storeu_ps(acc + 80, c5);
+	}
+}
+#endif
+
+// double: explicitly vectorized kernels when available, otherwise compound assignment on local arrays
+template<>
+struct GemmMicroKernel<double> {
+	static constexpr int MR = GemmRegisterBlock<double>::rows;
+	static constexpr int NR = GemmRegisterBlock<double>::columns;
+
+	static void run(int depth, const double* a, const double* b, double* c, int ldc, int row_count, int column_count, double alpha, bool) {
+		alignas(64) double acc[MR][NR] = {};
+#ifdef LINSOLVE_X86_SIMD
+		static_assert(MR == 6 && NR == 8, "vectorized kernels compute 6 x 8 blocks");
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::gemm_6x8_avx512(depth, a, b, &acc[0][0]); break;
+		case SimdLevel::AVX2: simd_detail::gemm_6x8_avx2(depth, a, b, &acc[0][0]); break;
+		default: accumulate(depth, a, b, acc); break;
+		}
+#else
+		accumulate(depth, a, b, acc);
+#endif
+
+		for (int i = 0; i < row_count; i++)
+			for (int j = 0; j < column_count; j++)
+				c[i * ldc + j] += alpha * acc[i][j];
+	}
+
+	static void accumulate(int depth, const double* a, const double* b, double (&acc)[MR][NR]) {
+		for (int p = 0; p < depth; p++, a += MR, b += NR)
+			for (int i = 0; i < MR; i++) {
+				const double a_ip = a[i];
+				for (int j = 0; j < NR; j++)
+					acc[i][j] += a_ip * b[j];
+			}
+	}
+};
+
+// float: same structure as the double kernel with 16 columns per block
+template<>
+struct GemmMicroKernel<float> {
+	static constexpr int MR = GemmRegisterBlock<float>::rows;
+	static constexpr int NR = GemmRegisterBlock<float>::columns;
+
+	static void run(int depth, const float* a, const float* b, float* c, int ldc, int row_count, int column_count, float alpha, bool) {
+		alignas(64) float acc[MR][NR] = {};
+#ifdef LINSOLVE_X86_SIMD
+		static_assert(MR == 6 && NR == 16, "vectorized kernels compute 6 x 16 blocks");
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::gemm_6x16_avx512(depth, a, b, &acc[0][0]); break;
+		case SimdLevel::AVX2: simd_detail::gemm_6x16_avx2(depth, a, b, &acc[0][0]); break;
+		default: accumulate(depth, a, b, acc); break;
+		}
+#else
+		accumulate(depth, a, b, acc);
+#endif
+
+		for (int i = 0; i < row_count; i++)
+			for (int j = 0; j < column_count; j++)
+				c[i * ldc + j] += alpha * acc[i][j];
+	}
+
+	static void accumulate(int depth, const float* a, const float* b, float (&acc)[MR][NR]) {
+		for (int p = 0; p < depth; p++, a += MR, b += NR)
+			for (int i = 0; i < MR; i++) {
+				const float a_ip = a[i];
+				for (int j = 0; j < NR; j++)
+					acc[i][j] += a_ip * b[j];
+			}
+	}
+};
+
+// std::complex<double>: real and imaginary parts are accumulated separately as doubles
+// avoids the NaN/infinity recovery that the standard complex multiplication performs on every product
+template<>
+struct GemmMicroKernel<std::complex<double>> {
+	static constexpr int MR = GemmRegisterBlock<std::complex<double>>::rows;
+	static constexpr int NR = GemmRegisterBlock<std::complex<double>>::columns;
+
+	static void run(int depth, const std::complex<double>* a, const std::complex<double>* b, std::complex<double>* c, int ldc, int row_count, int column_count, std::complex<double> alpha, bool) {
+		double acc_re[MR][NR] = {};
+		double acc_im[MR][NR] = {};
+		// std::complex<double> is guaranteed to have the layout of double[2]
+		const double* a_parts = reinterpret_cast<const double*>(a);
+		const double* b_parts = reinterpret_cast<const double*>(b);
+		for (int p = 0; p < depth; p++, a_parts += 2 * MR, b_parts += 2 * NR)
+			for (int i = 0; i < MR; i++) {
+				const double a_re = a_parts[2 * i];
+				const double a_im = a_parts[2 * i + 1];
+				for (int j = 0; j < NR; j++) {
+					acc_re[i][j] += a_re * b_parts[2 * j] - a_im * b_parts[2 * j + 1];
+					acc_im[i][j] += a_re * b_parts[2 * j + 1] + a_im * b_parts[2 * j];
+				}
+			}
+
+		for (int i = 0; i < row_count; i++)
+			for (int j = 0; j < column_count; j++) {
+				double re = alpha.real() * acc_re[i][j] - alpha.imag() * acc_im[i][j];
+				double im = alpha.real() * acc_im[i][j] + alpha.imag() * acc_re[i][j];
+				c[i * ldc + j] += std::complex<double>(re, im);
+			}
+	}
+};
+
+class Gemm {
+public:
+	// Tunable blocking parameters, the defaults keep a packed block of A in L2 and a packed block of B in L3 cache for double
+	static inline int block_rows = 96;
+	static inline int block_depth = 256;
+	static inline int block_columns = 2048;
+	// products with fewer multiplications than this are computed by a single thread
+	static inline long long parallel_threshold = 64 * 64 * 64;
+
+	// C = alpha * op(A) * op(B) + beta * C, where op(X) is X or X transposed
+	// dimensions are not checked, op(A) must be m x k, op(B) k x n and C m x n
+	template<typename T>
+	static void multiply(const MatrixView<const T>& a, bool transpose_a, const MatrixView<const T>& b, bool transpose_b,
+		const MatrixView<T>& c, T alpha = T(1), T beta = T(0));
+
+private:
+	template<typename T>
+	static void scale(const MatrixView<T>& c, T beta);
+	template<typename T>
+	static void pack_a(const MatrixView<const T>& a, bool transpose, int row, int depth_start, int row_count, int depth, T* packed);
+	template<typename T>
+	static void pack_b(const MatrixView<const T>& b, bool transpose, int depth_start, int column, int depth, int column_count, T* packed);
+};
+
+template<typename T>
+void Gemm::multiply(const MatrixView<const T>& a, bool transpose_a, const MatrixView<const T>& b, bool transpose_b,
+	const MatrixView<T>& c, T alpha, T beta)
+{
+	constexpr int MR = GemmRegisterBlock<T>::rows;
+	constexpr int NR = GemmRegisterBlock<T>::columns;
+
+	const int m = c.get_row_count();
+	const int n = c.get_column_count();
+	const int k = transpose_a ? a.get_row_count() : a.get_column_count();
+
+	scale(c, beta);
+	if (m == 0 || n == 0 || k == 0 || alpha == 0)
+		return;
+	const bool alpha_is_one = alpha == 1;
+
+	ThreadPool& pool = ThreadPool::instance();
+	const bool parallel = static_cast<long long>(m) * n * k >= parallel_threshold;
+
+	// when there are not enough row blocks for all threads, the blocks are made smaller
+	int mc = std::max(MR, block_rows / MR * MR);
+	if (parallel && pool.get_thread_count() > 1) {
+		int rows_per_thread = (m + pool.get_thread_count() - 1) / pool.get_thread_count();
+		rows_per_thread = (rows_per_thread + MR - 1) / MR * MR;
+		mc = std::min(mc, std::max(MR, rows_per_thread));
+	}
+	const int kc = std::max(1, block_depth);
+	const int nc = std::max(NR, block_columns / NR * NR);
+
+	// the packed block of B belongs to the calling thread and is kept between calls, so repeated products of the same size do not allocate;
+	// the row blocks running on the workers read it through the pointer (a thread_local named inside the loop would be the worker's own)
+	thread_local std::vector<T> packed_b_buffer;
+	packed_b_buffer.resize(static_cast<size_t>(kc) * ((std::min(nc, n) + NR - 1) / NR * NR));
+	T* const packed_b = packed_b_buffer.data();
+
+	for (int jc = 0; jc < n; jc += nc) {
+		const int column_count = std::min(nc, n - jc);
+		for (int pc = 0; pc < k; pc += kc) {
+			const int depth = std::min(kc, k - pc);
+			pack_b(b, transpose_b, pc, jc, depth, column_count, packed_b);
+
+			auto row_block = [&](int block) {
+				const int ic = block * mc;
+				const int row_count = std::min(mc, m - ic);
+				thread_local std::vector<T> packed_a;
+				packed_a.resize(static_cast<size_t>(depth) * ((row_count + MR - 1) / MR * MR));
+				pack_a(a, transpose_a, ic, pc, row_count, depth, packed_a.data());
+
+				for (int jr = 0; jr < column_count; jr += NR)
+					for (int ir = 0; ir < row_count; ir += MR)
+						GemmMicroKernel<T>::run(depth,
+							packed_a.data() + static_cast<size_t>(ir) * depth,
+							packed_b + static_cast<size_t>(jr) * depth,
+							&c(ic + ir, jc + jr), c.get_leading_dimension(),
+							std::min(MR, row_count - ir), std::min(NR, column_count - jr), alpha, alpha_is_one);
+			};
+
+			const int block_count = (m + mc - 1) / mc;
+			if (parallel)
+				pool.parallel_for(0, block_count, row_block);
+			else
+				for (int block = 0; block < block_count; block++)
+					row_block(block);
+		}
+	}
+}
+
+template<typename T>
+void Gemm::scale(const MatrixView<T>& c, T beta)
+{
+	if (beta == 1)
+		return;
+	const bool beta_is_zero = beta == 0;
+	for (int i = 0; i < c.get_row_count(); i++) {
+		T* row = c[i];
+		for (int j = 0; j < c.get_column_count(); j++)
+			row[j] = beta_is_zero ? T(0) : beta * row[j];
+	}
+}
+
+// Packs rows [row, row + row_count) and columns [depth_start, depth_start + depth) of op(A) into panels of MR rows
+// inside a panel the elements are stored column by column, missing rows of the last panel are filled with zeros
+template<typename T>
+void Gemm::pack_a(const MatrixView<const T>& a, bool transpose, int row, int depth_start, int row_count, int depth, T* packed)
+{
+	constexpr int MR = GemmRegisterBlock<T>::rows;
+	for (int ir = 0; ir < row_count; ir += MR) {
+		const int rows = std::min(MR, row_count - ir);
+		for (int p = 0; p < depth; p++, packed += MR) {
+			for (int i = 0; i < rows; i++)
+				packed[i] = transpose ? a(depth_start + p, row + ir + i) : a(row + ir + i, depth_start + p);
+			for (int i = rows; i < MR; i++)
+				packed[i] = T(0);
+		}
+	}
+}
+
+// Packs rows [depth_start, depth_start + depth) and columns [column, column + column_count) of op(B) into panels of NR columns
+// inside a panel the elements are stored row by row, missing columns of the last panel are filled with zeros
+template<typename T>
+void Gemm::pack_b(const MatrixView<const T>& b, bool transpose, int depth_start, int column, int depth, int column_count, T* packed)
+{
+	constexpr int NR = GemmRegisterBlock<T>::columns;
+	for (int jr = 0; jr < column_count; jr += NR) {
+		const int columns = std::min(NR, column_count - jr);
+		for (int p = 0; p < depth; p++, packed += NR) {
+			if (!transpose) {
+				const T* source = b[depth_start + p] + column + jr;
+				for (int j = 0; j < columns; j++)
+					packed[j] = source[j];
+			}
+			else {
+				for (int j = 0; j < columns; j++)
+					packed[j] = b(column + jr + j, depth_start + p);
+			}
+			for (int j = columns; j < NR; j++)
+				packed[j] = T(0);
+		}
+	}
+}
@@ -20,6 +20,8 @@
 #include "number_types.h"
 #include "matrix_loader.h"
 #include "LinSolver.h"
+#include "Factorization.h"
+#include "ExactSolver.h"
 
 #include "complex_extensions.h"
 
@@ -46,7 +48,7 @@ void test_lu(Matrix<T> matrix) {
 	cout << endl;
 	// Test by multiplication - multiplying L and U should result in original matrix
 	cout << "==== TEST ====" << endl;
-	(LinSolver::permuation_vector_to_matrix<T>(perm) * L * U).print();
+	Matrix<T>(LinSolver::permuation_vector_to_matrix<T>(perm) * L * U).print();
 	cout << endl;
 }
 
@@ -61,7 +63,7 @@ void test_qr(Matrix<T> matrix) {
 	cout << "==== R ====" << endl;
 	R.print();
 	cout << "==== TEST ====" << endl;
-	(Q * R).print(); // should result in original matrix
+	Matrix<T>(Q * R).print(); // should result in original matrix
 	cout << endl;
 }
 
@@ -118,9 +120,75 @@ void test_qr_solve(Matrix<T> system) {
 
 	qr.print();
 	cout << "Time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
+
+	// Test by substitution - the residual A * x - b should be close to zero, also for complex systems
+	int row_count = system.get_row_count();
+	Matrix<T> left(system.get_submatrix(0, 0, row_count, row_count)), right(system.get_submatrix(0, row_count, row_count, 1));
+	Matrix<T> residual(left * qr - right);
+	auto largest = abs(residual(0));
+	for (int i = 1; i < row_count; i++)
+		largest = max(largest, abs(residual(i)));
+	cout << "Largest residual: " << largest << endl;
+	cout << endl;
+}
+
+// The matrix is factorized once, the factorization can then be reused for any number of right sides
+template<typename T>
+void test_lu_factorization(Matrix<T> system) {
+	cout << "==== LU factorization ====" << endl;
+
+	int row_count = system.get_row_count();
+	auto start_time = chrono::high_resolution_clock::now();
+	LUFactorization<T> factorization(Matrix<T>(system.get_submatrix(0, 0, row_count, row_count)));
+	auto result = factorization.solve(Matrix<T>(system.get_submatrix(0, row_count, row_count, system.get_column_count() - row_count)));
+	auto end_time = chrono::high_resolution_clock::now();
+
+	result.print();
+	cout << "Time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
 	cout << endl;
 }
 
+// The algorithm is chosen by LinSolver::solve from the structure of the matrix
+template<typename T>
+void test_auto_solve(Matrix<T> system) {
+	cout << "==== Automatic ====" << endl;
+
+	auto start_time = chrono::high_resolution_clock::now();
+	auto result = LinSolver::solve(system);
+	auto end_time = chrono::high_resolution_clock::now();
+
+	result.solution.print();
+	cout << "Method: " << solver_method_name(result.method) << endl;
+	cout << "Time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
+	cout << endl;
+}
+
+// fraction-free Bareiss elimination, only for exact types (Fraction, Rational)
+template<Numerical T>
+void test_exact_solve(Matrix<T> system) {
+	if constexpr (std::is_same_v<T, Fraction> || std::is_same_v<T, Rational>) {
+		cout << "==== Bareiss ====" << endl;
+
+		auto start_time = chrono::high_resolution_clock::now();
+		auto result = ExactSolver::solve_bareiss(system);
+		auto end_time = chrono::high_resolution_clock::now();
+
+		result.print();
+		cout << "Time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
+		cout << endl;
+
+		cout << "==== Multi-modular ====" << endl;
+
+		start_time = chrono::high_resolution_clock::now();
+		result = ExactSolver::solve_multimodular(system);
+		end_time = chrono::high_resolution_clock::now();
+
+		result.print();
+		cout << "Time: " << chrono::duration_cast<chrono::microseconds>(end_time - start_time).count() << " microseconds" << endl;
+		cout << endl;
+	}
+}
+
 int main(int argc, char** argv) {
 	try {
 		cout << "Enter matrix in following format: " << endl << endl;
@@ -163,6 +231,25 @@ int main(int argc, char** argv) {
 			cout << ex.what() << endl << endl;
 		}
 
+		try {
+			test_lu_factorization(system);
+		}
+		catch (const exception& ex) {
+			cout << ex.what() << endl << endl;
+		}
+		try {
+			test_auto_solve(system);
+		}
+		catch (const exception& ex) {
+			cout << ex.what() << endl << endl;
+		}
+		try {
+			test_exact_solve(system);
+		}
+		catch (const exception& ex) {
+			cout << ex.what() << endl << endl;
+		}
+
 		// Tests for decompositions
 		// Input matrix must be square
 
@@ -8,6 +8,8 @@
 
 #include "Matrix.h"
 #include "number_types.h"
+#include "SparseMatrix.h"
+#include "BandedMatrix.h"
 
 class matrix_loader
 {
@@ -59,4 +61,54 @@ public:
 
 		return matrix;
 	}
+
+	// Loads sparse matrix from stream in the same format as load_compact
+	// The elements are read directly into the triplet arrays (no dense matrix is created), values given more than once for the same position are summed
+	template<Numerical T>
+	static SparseMatrix<T> load_compact_sparse(std::istream& input = std::cin) {
+		int row_count, column_count, to_read;
+		input >> row_count;
+		input >> column_count;
+		input >> to_read;
+		if (!input || row_count < 0 || column_count < 0 || to_read < 0)
+			throw MatrixException("Error: cannot read sparse matrix, invalid header");
+
+		std::vector<int> rows(to_read), columns(to_read);
+		std::vector<T> values(to_read);
+		for (int i = 0; i < to_read; i++)
+		{
+			input >> rows[i];
+			input >> columns[i];
+			input >> values[i];
+		}
+		if (!input)
+			throw MatrixException("Error: cannot read sparse matrix, unexpected end of input");
+
+		return SparseMatrix<T>::from_triplets(row_count, column_count, rows, columns, values);
+	}
+
+	// Loads banded matrix from stream in format:
+	// size lower_bandwidth upper_bandwidth
+	// elements of row 1 from column 1 to column 1 + upper_bandwidth
+	// ...
+	// elements of row i from column i - lower_bandwidth to column i + upper_bandwidth (only columns inside the matrix)
+	// Only the band is read and stored, no dense matrix is created
+	template<Numerical T>
+	static BandedMatrix<T> load_banded(std::istream& input = std::cin) {
+		int size, lower_bandwidth, upper_bandwidth;
+		input >> size;
+		input >> lower_bandwidth;
+		input >> upper_bandwidth;
+		if (!input || size < 0 || lower_bandwidth < 0 || upper_bandwidth < 0)
+			throw MatrixException("Error: cannot read banded matrix, invalid header");
+
+		BandedMatrix<T> matrix(size, lower_bandwidth, upper_bandwidth);
+		for (int i = 0; i < size; i++)
+			for (int j = std::max(0, i - lower_bandwidth); j <= std::min(size - 1, i + upper_bandwidth); j++)
+				input >> matrix(i, j);
+		if (!input)
+			throw MatrixException("Error: cannot read banded matrix, unexpected end of input");
+
+		return matrix;
+	}
 };
\ No newline at end of file
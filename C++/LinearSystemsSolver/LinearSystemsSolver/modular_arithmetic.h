@@ -0,0 +1,138 @@
+// modular_arithmetic.h
+// Arithmetic modulo a compile-time 64-bit modulus N < 2^63, the backend of FiniteGroup<N> (number_types.h)
+// Odd moduli use Montgomery reduction: a value a is stored as a * 2^64 mod N and the 128-bit product of two stored values
+// is reduced by REDC, two multiplications and an addition instead of a division; the constants (-N^-1 mod 2^64, 2^128 mod N)
+// are computed at compile time
+// Even moduli (which are not fields) keep the plain representation and reduce 128-bit products by a remainder
+// A stored value is reduced only once for a whole sum of products (reduce_sum), which is used by the dot products,
+// row updates and matrix products of FiniteGroup to accumulate in 128 bits with delayed reduction
+// 128-bit products use unsigned __int128 or _umul128 where available and 32-bit halves otherwise, all functions are constexpr
+
+#pragma once
+#include<cstdint>
+#include<type_traits>
+
+#include "checked_arithmetic.h"
+
+#if defined(_MSC_VER) && defined(_M_X64) && !defined(LINSOLVE_INT128)
+#include<intrin.h>
+#define LINSOLVE_UMUL128
+#endif
+
+// Unsigned 128-bit value as two 64-bit halves
+struct UInt128 {
+	uint64_t low = 0;
+	uint64_t high = 0;
+
+	static constexpr UInt128 multiply(const uint64_t a, const uint64_t b) {
+#ifdef LINSOLVE_INT128
+		unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+		return { static_cast<uint64_t>(product), static_cast<uint64_t>(product >> 64) };
+#else
+#ifdef LINSOLVE_UMUL128
+		if (!std::is_constant_evaluated()) {
+			UInt128 result;
+			result.low = _umul128(a, b, &result.high);
+			return result;
+		}
+#endif
+		uint64_t a_low = a & 0xFFFFFFFF, a_high = a >> 32, b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+		uint64_t low_low = a_low * b_low, low_high = a_low * b_high, high_low = a_high * b_low, high_high = a_high * b_high;
+		uint64_t middle = (low_low >> 32) + (low_high & 0xFFFFFFFF) + (high_low & 0xFFFFFFFF);
+		return { (middle << 32) | (low_low & 0xFFFFFFFF), high_high + (low_high >> 32) + (high_low >> 32) + (middle >> 32) };
+#endif
+	}
+
+	constexpr UInt128& operator+=(const UInt128& other) {
+		low += other.low;
+		high += other.high + (low < other.low ? 1 : 0);
+		return *this;
+	}
+
+	// value mod modulus, bit by bit where there is no 128-bit division (used at compile time, for even moduli and by the multi-modular solver)
+	constexpr uint64_t remainder(const uint64_t modulus) const {
+#ifdef LINSOLVE_INT128
+		return static_cast<uint64_t>(((static_cast<unsigned __int128>(high) << 64) | low) % modulus);
+#else
+		uint64_t rest = high % modulus;
+		for (int bit = 63; bit >= 0; bit--) {
+			// rest < modulus < 2^63, so doubling it does not overflow
+			rest = (rest << 1) | ((low >> bit) & 1);
+			if (rest >= modulus)
+				rest -= modulus;
+		}
+		return rest;
+#endif
+	}
+};
+
+template<unsigned long long N>
+struct ModularArithmetic {
+	static_assert(N > 1 && N < (1ull << 63), "modulus has to be in the range 2 ... 2^63 - 1");
+
+	static constexpr bool montgomery = N % 2 == 1;
+	// 2^64 mod N and 2^128 mod N
+	static constexpr uint64_t r = (0 - N) % N;
+	static constexpr uint64_t r_squared = UInt128::multiply(r, r).remainder(N);
+	// -N^-1 mod 2^64 by Newton's iteration, every step doubles the number of correct bits (N * N = 1 mod 8 for odd N)
+	static constexpr uint64_t negative_inverse = [] {
+		uint64_t inverse = N;
+		for (int i = 0; i < 5; i++)
+			inverse *= 2 - N * inverse;
+		return 0 - inverse;
+	}();
+
+	// canonical value (< N) -> stored value
+	static constexpr uint64_t to_stored(const uint64_t value) {
+		if constexpr (montgomery)
+			return reduce(UInt128::multiply(value, r_squared));
+		else
+			return value;
+	}
+	// stored value -> canonical value
+	static constexpr uint64_t from_stored(const uint64_t value) {
+		if constexpr (montgomery)
+			return reduce(UInt128{ value, 0 });
+		else
+			return value;
+	}
+
+	// stored value of the product of two stored values
+	static constexpr uint64_t multiply(const uint64_t a, const uint64_t b) {
+		return reduce(UInt128::multiply(a, b));
+	}
+	static constexpr uint64_t add(const uint64_t a, const uint64_t b) {
+		uint64_t sum = a + b;
+		return sum >= N ? sum - N : sum;
+	}
+	static constexpr uint64_t subtract(const uint64_t a, const uint64_t b) {
+		return a >= b ? a - b : a + N - b;
+	}
+
+	// Montgomery: value * 2^-64 mod N (REDC), the value has to be below N * 2^64; plain: value mod N
+	// Products of two stored values and sums of two such products are below N * 2^64 because N < 2^63
+	static constexpr uint64_t reduce(const UInt128 value) {
+		if constexpr (montgomery) {
+			uint64_t m = value.low * negative_inverse;
+			UInt128 mn = UInt128::multiply(m, N);
+			// value + m * N is divisible by 2^64, its low half is zero and carries exactly when value.low is not zero
+			uint64_t result = value.high + mn.high + (value.low != 0 ? 1 : 0);
+			return result >= N ? result - N : result;
+		}
+		else
+			return value.remainder(N);
+	}
+
+	// Sum of products accumulated in 128 bits, reduced once by reduce_sum
+	// The high half is brought below N before it could overflow, which changes the sum only by a multiple of N * 2^64
+	static constexpr void accumulate(UInt128& sum, const uint64_t a, const uint64_t b) {
+		sum += UInt128::multiply(a, b);
+		if (sum.high >= (1ull << 63))
+			sum.high %= N;
+	}
+	// stored value of a sum of products of stored values
+	static constexpr uint64_t reduce_sum(UInt128 sum) {
+		sum.high %= N;
+		return reduce(sum);
+	}
+};
@@ -40,7 +40,9 @@ Fraction Fraction::operator/(const Fraction other) const {
 	if (other.numerator == 0)
 		throw NumberTypeException("Error when dividing two fractions: dividing by zero.");
 
-	auto toReturn = Fraction(numerator, denominator) * Fraction(other.denominator, other.numerator);
+	// the sign of the divisor has to stay in the numerator of the reciprocal, the denominator is unsigned
+	long sign = other.numerator < 0 ? -1 : 1;
+	auto toReturn = Fraction(numerator, denominator) * Fraction(sign * static_cast<long>(other.denominator), static_cast<unsigned long>(sign * other.numerator));
 	toReturn.normalize();
 	return toReturn;
 }
@@ -63,7 +65,7 @@ Fraction Fraction::operator/(const int other) const
 
 // normalizing the fraction, using gcd algorithm from standard library
 void Fraction::normalize() {
-	int divider = gcd(numerator, denominator);
+	long divider = static_cast<long>(gcd(numerator, denominator));
 	numerator /= divider;
 	denominator /= divider;
 }
@@ -1,13 +1,19 @@
 // number_types.h
-// defines custom Fraction and FiniteGroup types
+// defines custom Fraction and FiniteGroup types (the arbitrary precision Rational type is in rational.h)
+// FiniteGroup arithmetic is constexpr, so fixed size systems over it (FixedMatrix.h) can be solved at compile time
+// FiniteGroup moduli can have up to 63 bits, the modular arithmetic is in modular_arithmetic.h
 
 #pragma once
 
 #include<compare>
 #include<iostream>
 #include<complex>
+#include<vector>
+#include<cstdint>
+#include<type_traits>
 
 #include "Matrix.h"
+#include "modular_arithmetic.h"
 
 // NumberTypeException: exception thrown by operations done on Fraction and FiniteGroup types
 // eg. when dividing by zero, or creating a fraction with denominator 0
@@ -17,7 +23,13 @@ public:
 	virtual const char* what() const throw() { return e_message.c_str(); }
 private:
 	std::string e_message;
-};;
+};
+
+// NumberOverflowException: thrown by exact computations when a value does not fit into the integers used to store it
+class NumberOverflowException : public NumberTypeException {
+public:
+	NumberOverflowException(const std::string& message) : NumberTypeException(message) {}
+};
 
 struct Fraction {
 public:
@@ -43,6 +55,8 @@ public:
 
 	operator double() { return static_cast<double>(numerator) / static_cast<double>(denominator); }
 	void normalize();
+	long get_numerator() const { return numerator; }
+	unsigned long get_denominator() const { return denominator; }
 
 	friend Fraction abs(const Fraction fraction) { return Fraction(abs(fraction.numerator), fraction.denominator); }
 	void print(std::ostream& stream = std::cout);
@@ -75,63 +89,191 @@ private:
 	}
 };
 
-template<int N>
+// FiniteGroup<N>: integers modulo N (a field when N is prime), N can be any modulus up to 2^63 - 1
+// The arithmetic is done by ModularArithmetic<N> (modular_arithmetic.h): values of odd moduli are stored in the Montgomery form,
+// so multiplications do not divide; comparisons, output and the conversions work with the canonical value 0 ... N - 1
+// Inverses are cached per thread (eliminations divide many elements by the same pivot), batch_inverse inverts a whole array
+// by a single inversion; dot products, row updates and matrix products accumulate in 128 bits and reduce once (see below)
+template<unsigned long long N>
 struct FiniteGroup {
 public:
-	FiniteGroup() : _value(0) {}
-	FiniteGroup(int value) : _value(((value%N)+N)%N) { }
+	using Arithmetic = ModularArithmetic<N>;
 
-	FiniteGroup operator+(const FiniteGroup<N> other) const { return FiniteGroup<N>(_value + other._value); }
-	FiniteGroup operator-(const FiniteGroup<N> other) const { return FiniteGroup<N>(_value - other._value + N); }
-	FiniteGroup operator*(const FiniteGroup<N> other) const { return FiniteGroup<N>(_value * other._value); }
-	FiniteGroup operator/(const FiniteGroup<N> other) const { return FiniteGroup<N>(_value * other.inverse()._value); }
+	constexpr FiniteGroup() : _value(0) {}
+	constexpr FiniteGroup(long long value) : _value(Arithmetic::to_stored(canonical(value))) { }
 
-	bool operator==(const FiniteGroup<N> other) const { return _value == other._value; }
-	bool operator!=(const FiniteGroup<N> other) const { return _value != other._value; }
-	auto operator<=>(const FiniteGroup<N>& other) const {
-		return _value <=> other._value;
+	constexpr FiniteGroup operator+(const FiniteGroup<N> other) const { return stored(Arithmetic::add(_value, other._value)); }
+	constexpr FiniteGroup operator-(const FiniteGroup<N> other) const { return stored(Arithmetic::subtract(_value, other._value)); }
+	constexpr FiniteGroup operator*(const FiniteGroup<N> other) const { return stored(Arithmetic::multiply(_value, other._value)); }
+	constexpr FiniteGroup operator/(const FiniteGroup<N> other) const { return *this * other.inverse(); }
+
+	constexpr bool operator==(const FiniteGroup<N> other) const { return _value == other._value; }
+	constexpr bool operator!=(const FiniteGroup<N> other) const { return _value != other._value; }
+	constexpr auto operator<=>(const FiniteGroup<N>& other) const {
+		return get_value() <=> other.get_value();
 	}
 
-	// checks for equality with an int by converting the int to a FiniteGroup
-	bool operator==(const int other) const { return _value == ((other%N)+N)%N; }
-	bool operator!=(const int other) const { return _value != ((other%N)+N)%N; }
+	// checks for equality with an integer by converting it to a FiniteGroup
+	constexpr bool operator==(const long long other) const { return _value == Arithmetic::to_stored(canonical(other)); }
+	constexpr bool operator!=(const long long other) const { return !(*this == other); }
+
+	friend constexpr FiniteGroup<N> abs(const FiniteGroup<N> val) { return val; }
+	constexpr FiniteGroup<N> operator-() const { return stored(_value == 0 ? 0 : N - _value); }
 
-	friend FiniteGroup<N> abs(const FiniteGroup<N> val) { return FiniteGroup<N>(val._value); }
-	FiniteGroup<N> operator-() const { return FiniteGroup<N>(N - _value); }
+	// canonical value 0 ... N - 1
+	constexpr unsigned long long get_value() const { return Arithmetic::from_stored(_value); }
+	constexpr FiniteGroup<N> inverse() const;
+	// inverses[i] = values[i]^-1 by Montgomery's trick: one inversion and 3 * (count - 1) multiplications, the arrays may be the same
+	static void batch_inverse(const FiniteGroup<N>* values, FiniteGroup<N>* inverses, const int count);
 
 	friend std::istream& operator>>(std::istream& input, FiniteGroup& val) {
-		int value;
+		long long value;
 		input >> value;
-		val = FiniteGroup<N>(value);	
+		val = FiniteGroup<N>(value);
 		return input;
 	}
 	friend std::ostream& operator<<(std::ostream& output, const FiniteGroup val) {
-		output << val._value;
+		output << val.get_value();
 		return output;
 	}
 
+	// entries of the per-thread inverse cache
+	static constexpr int inverse_cache_size = 64;
+
 private:
-	int _value;
+	friend struct VectorKernels<FiniteGroup<N>>;
+	friend struct GemmMicroKernel<FiniteGroup<N>>;
 
-	// finds the greatest common divider and values a, b such that a*x + b*y = gcd(a, b)
-	// used to find the modular inverse of a number
-	static int extended_gcd(int a, int b, int& x, int& y) {
-		if (a == 0) {
-			x = 0; y = 1; return b;
-		}
-		int x_temp, y_temp;
-		int gcd = extended_gcd(b % a, a, x_temp, y_temp);
-		x = y_temp - (b / a) * x_temp;
-		y = x_temp;
-		return gcd;
+	// stored (for odd N Montgomery) form of the value
+	uint64_t _value;
+
+	static constexpr FiniteGroup<N> stored(const uint64_t value) {
+		FiniteGroup<N> result;
+		result._value = value;
+		return result;
+	}
+	static constexpr uint64_t canonical(const long long value) {
+		constexpr long long modulus = static_cast<long long>(N);
+		long long rest = value % modulus;
+		return static_cast<uint64_t>(rest < 0 ? rest + modulus : rest);
 	}
 
-	FiniteGroup<N> inverse() const {
-		int gcd, x, y;
-		gcd = extended_gcd(_value, N, x, y);
-		if (gcd != 1)
+	// extended Euclidean algorithm on the canonical value, the coefficients stay below N in absolute value
+	static constexpr uint64_t compute_inverse(const uint64_t value) {
+		long long a = static_cast<long long>(value), b = static_cast<long long>(N);
+		long long x = 1, next_x = 0;
+		while (b != 0) {
+			long long quotient = a / b;
+			long long rest = a - quotient * b;
+			a = b;
+			b = rest;
+			long long temp = x - quotient * next_x;
+			x = next_x;
+			next_x = temp;
+		}
+		if (a != 1)
 			throw NumberTypeException("Error: modular inverse does not exist.");
-		return FiniteGroup<N>(x + N);
+		return static_cast<uint64_t>(x < 0 ? x + static_cast<long long>(N) : x);
+	}
+
+	// direct mapped cache indexed by the low bits of the stored value, zero (which has no inverse) marks an empty entry
+	static uint64_t cached_inverse(const uint64_t value) {
+		struct Entry { uint64_t value = 0; uint64_t inverse = 0; };
+		thread_local Entry cache[inverse_cache_size];
+		Entry& entry = cache[(value ^ (value >> 32)) % inverse_cache_size];
+		if (entry.value != value || value == 0) {
+			entry.inverse = Arithmetic::to_stored(compute_inverse(Arithmetic::from_stored(value)));
+			entry.value = value;
+		}
+		return entry.inverse;
+	}
+};
+
+template<unsigned long long N>
+constexpr FiniteGroup<N> FiniteGroup<N>::inverse() const
+{
+	if (std::is_constant_evaluated())
+		return stored(Arithmetic::to_stored(compute_inverse(get_value())));
+	return stored(cached_inverse(_value));
+}
+
+template<unsigned long long N>
+void FiniteGroup<N>::batch_inverse(const FiniteGroup<N>* values, FiniteGroup<N>* inverses, const int count)
+{
+	if (count <= 0)
+		return;
+	// prefix[i] = values[0] * ... * values[i]
+	std::vector<FiniteGroup<N>> prefix(count);
+	prefix[0] = values[0];
+	for (int i = 1; i < count; i++)
+		prefix[i] = prefix[i - 1] * values[i];
+	FiniteGroup<N> inverse = prefix[count - 1].inverse();
+	for (int i = count - 1; i > 0; i--) {
+		FiniteGroup<N> value = values[i];
+		inverses[i] = inverse * prefix[i - 1];
+		inverse = inverse * value;
+	}
+	inverses[0] = inverse;
+}
+
+// Delayed reduction: the products of the stored values are summed in 128 bits and reduced once per result element,
+// for odd moduli the sum of products of Montgomery forms reduced by REDC is directly the Montgomery form of the result
+template<unsigned long long N>
+struct VectorKernels<FiniteGroup<N>> {
+	using T = FiniteGroup<N>;
+	using Arithmetic = ModularArithmetic<N>;
+	static constexpr bool vectorized = false;
+
+	static void axpy(int n, T alpha, const T* x, T* y) {
+		for (int i = 0; i < n; i++)
+			y[i]._value = Arithmetic::add(y[i]._value, Arithmetic::multiply(alpha._value, x[i]._value));
+	}
+	static T dot(int n, const T* x, const T* y) {
+		UInt128 sum;
+		for (int i = 0; i < n; i++)
+			Arithmetic::accumulate(sum, x[i]._value, y[i]._value);
+		return T::stored(Arithmetic::reduce_sum(sum));
+	}
+	// a * x + b * y is a sum of two products below N * 2^64, reduced once
+	static void row_update(int n, T a, const T* x, T b, T* y) {
+		for (int i = 0; i < n; i++) {
+			UInt128 sum = UInt128::multiply(a._value, x[i]._value);
+			sum += UInt128::multiply(b._value, y[i]._value);
+			y[i]._value = Arithmetic::reduce(sum);
+		}
+	}
+	static void lane_axpy(int n, const T* alpha, const T* x, T* y) {
+		for (int k = 0; k < n; k++)
+			for (int l = 0; l < simd_lanes; l++)
+				y[k * simd_lanes + l]._value = Arithmetic::add(y[k * simd_lanes + l]._value, Arithmetic::multiply(alpha[l]._value, x[k * simd_lanes + l]._value));
+	}
+	static T sparse_dot(int n, const T* values, const int* indices, const T* x) {
+		UInt128 sum;
+		for (int i = 0; i < n; i++)
+			Arithmetic::accumulate(sum, values[i]._value, x[indices[i]]._value);
+		return T::stored(Arithmetic::reduce_sum(sum));
 	}
 };
 
+// The register block of a matrix product keeps a 128-bit sum for every element and reduces it once after the whole depth
+template<unsigned long long N>
+struct GemmMicroKernel<FiniteGroup<N>> {
+	using T = FiniteGroup<N>;
+	using Arithmetic = ModularArithmetic<N>;
+	static constexpr int MR = GemmRegisterBlock<T>::rows;
+	static constexpr int NR = GemmRegisterBlock<T>::columns;
+
+	static void run(int depth, const T* a, const T* b, T* c, int ldc, int row_count, int column_count, T alpha, bool alpha_is_one) {
+		UInt128 acc[MR][NR] = {};
+		for (int p = 0; p < depth; p++, a += MR, b += NR)
+			for (int i = 0; i < MR; i++)
+				for (int j = 0; j < NR; j++)
+					Arithmetic::accumulate(acc[i][j], a[i]._value, b[j]._value);
+
+		for (int i = 0; i < row_count; i++)
+			for (int j = 0; j < column_count; j++) {
+				T product = T::stored(Arithmetic::reduce_sum(acc[i][j]));
+				c[i * ldc + j] = c[i * ldc + j] + (alpha_is_one ? product : alpha * product);
+			}
+	}
+};
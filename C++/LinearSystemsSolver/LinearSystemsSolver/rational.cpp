@@ -0,0 +1,599 @@
+// rational.cpp
+// Definitions of functions for the BigInteger and Rational types
+
+#include<bit>
+#include<cmath>
+#include<cctype>
+#include<limits>
+#include<algorithm>
+
+#include "rational.h"
+
+using namespace std;
+
+// ==== BigInteger ====
+
+BigInteger::BigInteger(long long value) : _negative(value < 0)
+{
+	unsigned long long magnitude = value < 0 ? 0ull - static_cast<unsigned long long>(value) : static_cast<unsigned long long>(value);
+	while (magnitude != 0) {
+		_limbs.push_back(static_cast<uint32_t>(magnitude));
+		magnitude >>= 32;
+	}
+}
+
+BigInteger::BigInteger(const string& digits)
+{
+	size_t position = 0;
+	bool negative = false;
+	if (position < digits.size() && (digits[position] == '-' || digits[position] == '+'))
+		negative = digits[position++] == '-';
+	if (position == digits.size())
+		throw NumberTypeException("Error: cannot read big integer, invalid format.");
+	for (; position < digits.size(); position++) {
+		if (!isdigit(static_cast<unsigned char>(digits[position])))
+			throw NumberTypeException("Error: cannot read big integer, invalid format.");
+		multiply_add_small(_limbs, 10, static_cast<uint32_t>(digits[position] - '0'));
+	}
+	_negative = negative && !is_zero();
+}
+
+BigInteger BigInteger::operator-() const
+{
+	BigInteger result = *this;
+	result._negative = !_negative && !is_zero();
+	return result;
+}
+
+BigInteger BigInteger::operator+(const BigInteger& other) const
+{
+	return add_signed(_negative, _limbs, other._negative, other._limbs);
+}
+
+BigInteger BigInteger::operator-(const BigInteger& other) const
+{
+	return add_signed(_negative, _limbs, !other._negative, other._limbs);
+}
+
+BigInteger BigInteger::operator*(const BigInteger& other) const
+{
+	BigInteger result;
+	multiply_magnitudes(_limbs, other._limbs, result._limbs);
+	result._negative = _negative != other._negative && !result.is_zero();
+	return result;
+}
+
+BigInteger BigInteger::operator/(const BigInteger& other) const
+{
+	BigInteger quotient, remainder;
+	divide(*this, other, quotient, remainder);
+	return quotient;
+}
+
+BigInteger BigInteger::operator%(const BigInteger& other) const
+{
+	BigInteger quotient, remainder;
+	divide(*this, other, quotient, remainder);
+	return remainder;
+}
+
+void BigInteger::divide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient, BigInteger& remainder)
+{
+	if (divisor.is_zero())
+		throw NumberTypeException("Error when dividing big integers: dividing by zero.");
+	divide_magnitudes(dividend._limbs, divisor._limbs, quotient._limbs, remainder._limbs);
+	quotient._negative = dividend._negative != divisor._negative && !quotient.is_zero();
+	remainder._negative = dividend._negative && !remainder.is_zero();
+}
+
+strong_ordering BigInteger::operator<=>(const BigInteger& other) const
+{
+	if (_negative != other._negative)
+		return _negative ? strong_ordering::less : strong_ordering::greater;
+	int comparison = _negative ? compare_magnitudes(other._limbs, _limbs) : compare_magnitudes(_limbs, other._limbs);
+	return comparison <=> 0;
+}
+
+BigInteger abs(const BigInteger& value)
+{
+	BigInteger result = value;
+	result._negative = false;
+	return result;
+}
+
+// Euclidean algorithm, every step is one division
+BigInteger BigInteger::gcd(BigInteger a, BigInteger b)
+{
+	a._negative = false;
+	b._negative = false;
+	while (!b.is_zero()) {
+		BigInteger quotient, remainder;
+		divide(a, b, quotient, remainder);
+		a = move(b);
+		b = move(remainder);
+	}
+	return a;
+}
+
+// Newton's iteration started above the root decreases monotonically to the floor of the root
+BigInteger BigInteger::sqrt() const
+{
+	if (_negative)
+		throw NumberTypeException("Error: square root of a negative big integer.");
+	if (is_zero())
+		return BigInteger();
+	// 2^(32 * ceil(limbs / 2)) is at least the root
+	BigInteger root;
+	root._limbs.assign((_limbs.size() + 1) / 2, 0);
+	root._limbs.push_back(1);
+	while (true) {
+		BigInteger next = (root + *this / root) / BigInteger(2);
+		if (!(next < root))
+			return root;
+		root = move(next);
+	}
+}
+
+unsigned long long BigInteger::remainder(const unsigned long long modulus) const
+{
+	uint64_t rest = 0;
+	for (int i = get_limb_count() - 1; i >= 0; i--)
+		rest = UInt128{ (rest << 32) | _limbs[i], rest >> 32 }.remainder(modulus);
+	return _negative && rest != 0 ? modulus - rest : rest;
+}
+
+bool BigInteger::to_long_long(long long& value) const
+{
+	if (_limbs.size() > 2)
+		return false;
+	unsigned long long magnitude = 0;
+	for (int i = get_limb_count() - 1; i >= 0; i--)
+		magnitude = (magnitude << 32) | _limbs[i];
+	constexpr unsigned long long max = static_cast<unsigned long long>(numeric_limits<long long>::max());
+	if (magnitude > max + (_negative ? 1 : 0))
+		return false;
+	value = _negative ? static_cast<long long>(0ull - magnitude) : static_cast<long long>(magnitude);
+	return true;
+}
+
+double BigInteger::to_double(int& exponent) const
+{
+	int count = get_limb_count();
+	int used = min(count, 2);
+	unsigned long long top = 0;
+	for (int i = count - 1; i >= count - used; i--)
+		top = (top << 32) | _limbs[i];
+	exponent = 32 * (count - used);
+	double mantissa = static_cast<double>(top);
+	return _negative ? -mantissa : mantissa;
+}
+
+// the magnitude is divided by 10^9 repeatedly, every remainder gives nine digits
+string BigInteger::to_string() const
+{
+	if (is_zero())
+		return "0";
+	Limbs magnitude = _limbs;
+	vector<uint32_t> chunks;
+	while (!magnitude.empty())
+		chunks.push_back(divide_small(magnitude, 1000000000));
+	string digits = _negative ? "-" : "";
+	digits += std::to_string(chunks.back());
+	for (int i = static_cast<int>(chunks.size()) - 2; i >= 0; i--) {
+		string chunk = std::to_string(chunks[i]);
+		digits += string(9 - chunk.size(), '0') + chunk;
+	}
+	return digits;
+}
+
+int BigInteger::compare_magnitudes(const Limbs& a, const Limbs& b)
+{
+	if (a.size() != b.size())
+		return a.size() < b.size() ? -1 : 1;
+	for (int i = static_cast<int>(a.size()) - 1; i >= 0; i--)
+		if (a[i] != b[i])
+			return a[i] < b[i] ? -1 : 1;
+	return 0;
+}
+
+void BigInteger::add_magnitudes(const Limbs& a, const Limbs& b, Limbs& result)
+{
+	const Limbs& longer = a.size() >= b.size() ? a : b;
+	const Limbs& shorter = a.size() >= b.size() ? b : a;
+	Limbs sum(longer.size() + 1);
+	uint64_t carry = 0;
+	for (size_t i = 0; i < longer.size(); i++) {
+		carry += static_cast<uint64_t>(longer[i]) + (i < shorter.size() ? shorter[i] : 0);
+		sum[i] = static_cast<uint32_t>(carry);
+		carry >>= 32;
+	}
+	sum[longer.size()] = static_cast<uint32_t>(carry);
+	trim(sum);
+	result = move(sum);
+}
+
+void BigInteger::subtract_magnitudes(const Limbs& a, const Limbs& b, Limbs& result)
+{
+	Limbs difference(a.size());
+	int64_t borrow = 0;
+	for (size_t i = 0; i < a.size(); i++) {
+		int64_t value = static_cast<int64_t>(a[i]) - (i < b.size() ? b[i] : 0) - borrow;
+		borrow = value < 0 ? 1 : 0;
+		difference[i] = static_cast<uint32_t>(value + (borrow << 32));
+	}
+	trim(difference);
+	result = move(difference);
+}
+
+// schoolbook multiplication, the exact systems work with numbers of at most a few hundred limbs
+void BigInteger::multiply_magnitudes(const Limbs& a, const Limbs& b, Limbs& result)
+{
+	if (a.empty() || b.empty()) {
+		result.clear();
+		return;
+	}
+	Limbs product(a.size() + b.size(), 0);
+	for (size_t i = 0; i < a.size(); i++) {
+		uint64_t carry = 0;
+		for (size_t j = 0; j < b.size(); j++) {
+			carry += static_cast<uint64_t>(a[i]) * b[j] + product[i + j];
+			product[i + j] = static_cast<uint32_t>(carry);
+			carry >>= 32;
+		}
+		product[i + b.size()] = static_cast<uint32_t>(carry);
+	}
+	trim(product);
+	result = move(product);
+}
+
+// Long division of Knuth (The Art of Computer Programming, vol. 2, algorithm D): the divisor is shifted so its top limb has the highest bit set,
+// then every quotient limb is estimated from the top two limbs of the remainder and corrected at most twice
+void BigInteger::divide_magnitudes(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder)
+{
+	if (compare_magnitudes(a, b) < 0) {
+		remainder = a;
+		quotient.clear();
+		return;
+	}
+	if (b.size() == 1) {
+		Limbs result = a;
+		uint32_t rest = divide_small(result, b[0]);
+		quotient = move(result);
+		remainder.clear();
+		if (rest != 0)
+			remainder.push_back(rest);
+		return;
+	}
+
+	const int n = static_cast<int>(b.size());
+	const int m = static_cast<int>(a.size()) - n;
+	const int shift = countl_zero(b.back());
+	Limbs divisor(n), rest(a.size() + 1);
+	for (int i = n - 1; i > 0; i--)
+		divisor[i] = shift == 0 ? b[i] : (b[i] << shift) | (b[i - 1] >> (32 - shift));
+	divisor[0] = b[0] << shift;
+	rest[a.size()] = shift == 0 ? 0 : a.back() >> (32 - shift);
+	for (int i = static_cast<int>(a.size()) - 1; i > 0; i--)
+		rest[i] = shift == 0 ? a[i] : (a[i] << shift) | (a[i - 1] >> (32 - shift));
+	rest[0] = a[0] << shift;
+
+	constexpr uint64_t base = 1ull << 32;
+	Limbs result(m + 1, 0);
+	for (int j = m; j >= 0; j--) {
+		uint64_t top = (static_cast<uint64_t>(rest[j + n]) << 32) | rest[j + n - 1];
+		uint64_t estimate = top / divisor[n - 1];
+		uint64_t estimate_rest = top % divisor[n - 1];
+		while (estimate >= base || estimate * divisor[n - 2] > ((estimate_rest << 32) | rest[j + n - 2])) {
+			estimate--;
+			estimate_rest += divisor[n - 1];
+			if (estimate_rest >= base)
+				break;
+		}
+
+		// rest = rest - estimate * divisor, shifted by j limbs
+		int64_t borrow = 0;
+		for (int i = 0; i < n; i++) {
+			uint64_t product = estimate * divisor[i];
+			int64_t value = static_cast<int64_t>(rest[i + j]) - borrow - static_cast<int64_t>(product & 0xFFFFFFFF);
+			rest[i + j] = static_cast<uint32_t>(value);
+			borrow = static_cast<int64_t>(product >> 32) - (value >> 32);
+		}
+		int64_t value = static_cast<int64_t>(rest[j + n]) - borrow;
+		rest[j + n] = static_cast<uint32_t>(value);
+
+		// the estimate was one too big, the divisor is added back
+		if (value < 0) {
+			estimate--;
+			uint64_t carry = 0;
+			for (int i = 0; i < n; i++) {
+				carry += static_cast<uint64_t>(rest[i + j]) + divisor[i];
+				rest[i + j] = static_cast<uint32_t>(carry);
+				carry >>= 32;
+			}
+			rest[j + n] += static_cast<uint32_t>(carry);
+		}
+		result[j] = static_cast<uint32_t>(estimate);
+	}
+
+	remainder.assign(n, 0);
+	for (int i = 0; i < n; i++)
+		remainder[i] = shift == 0 ? rest[i] : (rest[i] >> shift) | (rest[i + 1] << (32 - shift));
+	trim(remainder);
+	trim(result);
+	quotient = move(result);
+}
+
+uint32_t BigInteger::divide_small(Limbs& a, const uint32_t divisor)
+{
+	uint64_t rest = 0;
+	for (int i = static_cast<int>(a.size()) - 1; i >= 0; i--) {
+		uint64_t current = (rest << 32) | a[i];
+		a[i] = static_cast<uint32_t>(current / divisor);
+		rest = current % divisor;
+	}
+	trim(a);
+	return static_cast<uint32_t>(rest);
+}
+
+void BigInteger::multiply_add_small(Limbs& a, const uint32_t factor, const uint32_t addend)
+{
+	uint64_t carry = addend;
+	for (auto&& limb : a) {
+		carry += static_cast<uint64_t>(limb) * factor;
+		limb = static_cast<uint32_t>(carry);
+		carry >>= 32;
+	}
+	if (carry != 0)
+		a.push_back(static_cast<uint32_t>(carry));
+}
+
+void BigInteger::trim(Limbs& a)
+{
+	while (!a.empty() && a.back() == 0)
+		a.pop_back();
+}
+
+BigInteger BigInteger::add_signed(const bool a_negative, const Limbs& a, const bool b_negative, const Limbs& b)
+{
+	BigInteger result;
+	if (a_negative == b_negative) {
+		add_magnitudes(a, b, result._limbs);
+		result._negative = a_negative;
+	}
+	else if (compare_magnitudes(a, b) >= 0) {
+		subtract_magnitudes(a, b, result._limbs);
+		result._negative = a_negative;
+	}
+	else {
+		subtract_magnitudes(b, a, result._limbs);
+		result._negative = b_negative;
+	}
+	result._negative = result._negative && !result.is_zero();
+	return result;
+}
+
+// ==== Rational ====
+
+Rational::Rational(long long numerator, long long denominator)
+{
+	if (denominator == 0)
+		throw NumberTypeException("Error: cannot create rational number, denominator is zero.");
+	if (!set_small(numerator, denominator))
+		*this = from_big(BigInteger(numerator), BigInteger(denominator));
+}
+
+Rational::Rational(const BigInteger& numerator, const BigInteger& denominator)
+{
+	*this = from_big(numerator, denominator);
+}
+
+Rational::Rational(const Fraction& fraction)
+{
+	unsigned long long denominator = fraction.get_denominator();
+	constexpr unsigned long long max = static_cast<unsigned long long>(numeric_limits<long long>::max());
+	if (denominator <= max)
+		*this = Rational(static_cast<long long>(fraction.get_numerator()), static_cast<long long>(denominator));
+	else
+		*this = from_big(BigInteger(fraction.get_numerator()), BigInteger(static_cast<long long>(denominator / 2)) * BigInteger(2) + BigInteger(static_cast<long long>(denominator % 2)));
+}
+
+// Products of two 64-bit values always fit into 128 bits, so the small path is exact;
+// when the result does not fit into 64 bits, set_small tries the reduced value before the big path is taken
+Rational Rational::operator+(const Rational& other) const
+{
+	if (!_big && !other._big) {
+		WideInt left, right, numerator, denominator;
+		Rational result;
+		if (CheckedArithmetic::multiply<WideInt>(_numerator, other._denominator, left) && CheckedArithmetic::multiply<WideInt>(other._numerator, _denominator, right)
+			&& CheckedArithmetic::add(left, right, numerator) && CheckedArithmetic::multiply<WideInt>(_denominator, other._denominator, denominator)
+			&& result.set_small(numerator, denominator))
+			return result;
+	}
+	return from_big(big_numerator() * other.big_denominator() + other.big_numerator() * big_denominator(), big_denominator() * other.big_denominator());
+}
+
+Rational Rational::operator-(const Rational& other) const
+{
+	if (!_big && !other._big) {
+		WideInt left, right, numerator, denominator;
+		Rational result;
+		if (CheckedArithmetic::multiply<WideInt>(_numerator, other._denominator, left) && CheckedArithmetic::multiply<WideInt>(other._numerator, _denominator, right)
+			&& CheckedArithmetic::subtract(left, right, numerator) && CheckedArithmetic::multiply<WideInt>(_denominator, other._denominator, denominator)
+			&& result.set_small(numerator, denominator))
+			return result;
+	}
+	return from_big(big_numerator() * other.big_denominator() - other.big_numerator() * big_denominator(), big_denominator() * other.big_denominator());
+}
+
+Rational Rational::operator*(const Rational& other) const
+{
+	if (!_big && !other._big) {
+		WideInt numerator, denominator;
+		Rational result;
+		if (CheckedArithmetic::multiply<WideInt>(_numerator, other._numerator, numerator) && CheckedArithmetic::multiply<WideInt>(_denominator, other._denominator, denominator)
+			&& result.set_small(numerator, denominator))
+			return result;
+	}
+	return from_big(big_numerator() * other.big_numerator(), big_denominator() * other.big_denominator());
+}
+
+Rational Rational::operator/(const Rational& other) const
+{
+	if (other == 0)
+		throw NumberTypeException("Error when dividing two rational numbers: dividing by zero.");
+	if (!_big && !other._big) {
+		WideInt numerator, denominator;
+		Rational result;
+		if (CheckedArithmetic::multiply<WideInt>(_numerator, other._denominator, numerator) && CheckedArithmetic::multiply<WideInt>(_denominator, other._numerator, denominator)
+			&& result.set_small(numerator, denominator))
+			return result;
+	}
+	return from_big(big_numerator() * other.big_denominator(), big_denominator() * other.big_numerator());
+}
+
+Rational Rational::operator-() const
+{
+	if (_big) {
+		Rational result;
+		result._big = make_shared<const BigValue>(BigValue{ -_big->numerator, _big->denominator });
+		return result;
+	}
+	if (_numerator == numeric_limits<long long>::min())
+		return from_big(-BigInteger(_numerator), BigInteger(_denominator));
+	Rational result;
+	result._numerator = -_numerator;
+	result._denominator = _denominator;
+	return result;
+}
+
+// the denominators are positive, so a / b <=> c / d is a * d <=> c * b
+strong_ordering Rational::operator<=>(const Rational& other) const
+{
+	if (!_big && !other._big) {
+		WideInt left, right;
+		if (CheckedArithmetic::multiply<WideInt>(_numerator, other._denominator, left) && CheckedArithmetic::multiply<WideInt>(other._numerator, _denominator, right))
+			return left <=> right;
+	}
+	return big_numerator() * other.big_denominator() <=> other.big_numerator() * big_denominator();
+}
+
+bool Rational::operator==(const Rational& other) const
+{
+	return (*this <=> other) == 0;
+}
+
+// big values are normalized and would be small if they were integers that fit into long long
+bool Rational::operator==(const long long other) const
+{
+	if (_big)
+		return false;
+	WideInt product;
+	return CheckedArithmetic::multiply<WideInt>(other, _denominator, product) && product == _numerator;
+}
+
+Rational::operator double() const
+{
+	if (!_big)
+		return static_cast<double>(_numerator) / static_cast<double>(_denominator);
+	int numerator_exponent, denominator_exponent;
+	double numerator = _big->numerator.to_double(numerator_exponent);
+	double denominator = _big->denominator.to_double(denominator_exponent);
+	return ldexp(numerator / denominator, numerator_exponent - denominator_exponent);
+}
+
+void Rational::normalize()
+{
+	if (_big)
+		return;
+	unsigned long long magnitude = _numerator < 0 ? 0ull - static_cast<unsigned long long>(_numerator) : static_cast<unsigned long long>(_numerator);
+	long long divisor = static_cast<long long>(CheckedArithmetic::gcd(magnitude, static_cast<unsigned long long>(_denominator)));
+	_numerator /= divisor;
+	_denominator /= divisor;
+}
+
+BigInteger Rational::get_numerator() const
+{
+	Rational normalized = *this;
+	normalized.normalize();
+	return normalized.big_numerator();
+}
+
+BigInteger Rational::get_denominator() const
+{
+	Rational normalized = *this;
+	normalized.normalize();
+	return normalized.big_denominator();
+}
+
+bool Rational::set_small(WideInt numerator, WideInt denominator)
+{
+	if (denominator < 0 && (!CheckedArithmetic::subtract(WideInt(0), numerator, numerator) || !CheckedArithmetic::subtract(WideInt(0), denominator, denominator)))
+		return false;
+	long long small_numerator, small_denominator;
+	if (!CheckedArithmetic::narrow(numerator, small_numerator) || !CheckedArithmetic::narrow(denominator, small_denominator)) {
+		WideInt magnitude;
+		if (!CheckedArithmetic::subtract(WideInt(0), numerator, magnitude))
+			return false;
+		WideInt divisor = CheckedArithmetic::gcd(numerator < 0 ? magnitude : numerator, denominator);
+		if (!CheckedArithmetic::narrow(numerator / divisor, small_numerator) || !CheckedArithmetic::narrow(denominator / divisor, small_denominator))
+			return false;
+	}
+	_numerator = small_numerator;
+	_denominator = small_denominator;
+	_big.reset();
+	return true;
+}
+
+Rational Rational::from_big(BigInteger numerator, BigInteger denominator)
+{
+	if (denominator.is_zero())
+		throw NumberTypeException("Error: cannot create rational number, denominator is zero.");
+	if (denominator.is_negative()) {
+		numerator = -numerator;
+		denominator = -denominator;
+	}
+	BigInteger divisor = BigInteger::gcd(numerator, denominator);
+	if (!(divisor == BigInteger(1))) {
+		numerator = numerator / divisor;
+		denominator = denominator / divisor;
+	}
+
+	Rational result;
+	long long small_numerator, small_denominator;
+	if (numerator.to_long_long(small_numerator) && denominator.to_long_long(small_denominator)) {
+		result._numerator = small_numerator;
+		result._denominator = small_denominator;
+	}
+	else
+		result._big = make_shared<const BigValue>(BigValue{ move(numerator), move(denominator) });
+	return result;
+}
+
+// loads a rational number in the form a/b or a, the numbers are read as digit strings of any length
+istream& operator>>(istream& input, Rational& value)
+{
+	string token;
+	if (!(input >> token))
+		return input;
+	size_t slash = token.find('/');
+	if (slash == string::npos)
+		value = Rational(BigInteger(token));
+	else
+		value = Rational(BigInteger(token.substr(0, slash)), BigInteger(token.substr(slash + 1)));
+	return input;
+}
+
+// if the denominator is equal to 1, the number is outputted as a single number
+ostream& operator<<(ostream& output, const Rational& value)
+{
+	Rational normalized = value;
+	normalized.normalize();
+	if (!normalized._big) {
+		if (normalized._denominator == 1)
+			return output << normalized._numerator;
+		return output << normalized._numerator << '/' << normalized._denominator;
+	}
+	if (normalized._big->denominator == BigInteger(1))
+		return output << normalized._big->numerator;
+	return output << normalized._big->numerator << '/' << normalized._big->denominator;
+}
@@ -0,0 +1,135 @@
+// rational.h
+// Defines the arbitrary precision BigInteger type and the exact Rational type built on it
+// Rational satisfies the Numerical concept and is meant as the exact alternative to Fraction that never overflows:
+// values are kept inline as a pair of 64-bit integers while they fit, every operation on them is done in 128 bits (checked_arithmetic.h)
+// and only a result that does not fit into 64 bits even after reduction is promoted to a pair of heap allocated BigIntegers
+// Small values are not normalized after every operation, the gcd is computed only when a result overflows and when the value is printed;
+// comparisons cross-multiply in 128 bits, which does not need normalized values
+// Big values are normalized after every operation (without it their size would double with every addition)
+// and demoted back to the small representation as soon as they fit
+
+#pragma once
+#include<vector>
+#include<string>
+#include<memory>
+#include<compare>
+#include<cstdint>
+#include<iostream>
+
+#include "number_types.h"
+#include "checked_arithmetic.h"
+#include "modular_arithmetic.h"
+
+// Sign and magnitude integer, the magnitude is stored as little endian 32-bit limbs without leading zero limbs (zero has no limbs)
+class BigInteger {
+public:
+	BigInteger() = default;
+	BigInteger(long long value);
+	// decimal digits with an optional sign
+	explicit BigInteger(const std::string& digits);
+
+	bool is_zero() const { return _limbs.empty(); }
+	bool is_negative() const { return _negative; }
+	int get_limb_count() const { return static_cast<int>(_limbs.size()); }
+
+	BigInteger operator-() const;
+	BigInteger operator+(const BigInteger& other) const;
+	BigInteger operator-(const BigInteger& other) const;
+	BigInteger operator*(const BigInteger& other) const;
+	// quotient rounded towards zero and the remainder with the sign of the dividend, as for built-in integers
+	BigInteger operator/(const BigInteger& other) const;
+	BigInteger operator%(const BigInteger& other) const;
+	static void divide(const BigInteger& dividend, const BigInteger& divisor, BigInteger& quotient, BigInteger& remainder);
+
+	std::strong_ordering operator<=>(const BigInteger& other) const;
+	bool operator==(const BigInteger& other) const { return _negative == other._negative && _limbs == other._limbs; }
+
+	friend BigInteger abs(const BigInteger& value);
+	// greatest common divisor of the absolute values
+	static BigInteger gcd(BigInteger a, BigInteger b);
+	// floor of the square root of a non-negative value
+	BigInteger sqrt() const;
+	// value mod modulus in 0 ... modulus - 1 (also for negative values), the modulus has to be below 2^63
+	unsigned long long remainder(const unsigned long long modulus) const;
+
+	// false when the value does not fit into long long
+	bool to_long_long(long long& value) const;
+	// value = mantissa * 2^exponent, the mantissa holds the highest 64 bits, so huge values do not overflow
+	double to_double(int& exponent) const;
+	std::string to_string() const;
+
+	friend std::ostream& operator<<(std::ostream& output, const BigInteger& value) { return output << value.to_string(); }
+
+private:
+	using Limbs = std::vector<uint32_t>;
+
+	static int compare_magnitudes(const Limbs& a, const Limbs& b);
+	static void add_magnitudes(const Limbs& a, const Limbs& b, Limbs& result);
+	// |a| >= |b|
+	static void subtract_magnitudes(const Limbs& a, const Limbs& b, Limbs& result);
+	static void multiply_magnitudes(const Limbs& a, const Limbs& b, Limbs& result);
+	static void divide_magnitudes(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder);
+	// a = a / divisor, returns the remainder
+	static uint32_t divide_small(Limbs& a, const uint32_t divisor);
+	// a = a * factor + addend
+	static void multiply_add_small(Limbs& a, const uint32_t factor, const uint32_t addend);
+	static void trim(Limbs& a);
+	// sum (or difference) of two values given by sign and magnitude
+	static BigInteger add_signed(const bool a_negative, const Limbs& a, const bool b_negative, const Limbs& b);
+
+	bool _negative = false;
+	Limbs _limbs;
+};
+
+class Rational {
+public:
+	Rational() : _numerator(0), _denominator(1) {}
+	Rational(long long numerator, long long denominator = 1);
+	Rational(const BigInteger& numerator, const BigInteger& denominator = BigInteger(1));
+	explicit Rational(const Fraction& fraction);
+
+	Rational operator+(const Rational& other) const;
+	Rational operator-(const Rational& other) const;
+	Rational operator*(const Rational& other) const;
+	Rational operator/(const Rational& other) const;
+	Rational operator-() const;
+
+	std::strong_ordering operator<=>(const Rational& other) const;
+	bool operator==(const Rational& other) const;
+	bool operator==(const long long other) const;
+
+	friend Rational abs(const Rational& value) { return value < Rational() ? -value : value; }
+	explicit operator double() const;
+
+	// divides the numerator and the denominator by their gcd, done by the operations only when needed
+	void normalize();
+	// the value uses the heap allocated representation
+	bool is_big() const { return _big != nullptr; }
+	// normalized numerator and denominator, the denominator is positive
+	BigInteger get_numerator() const;
+	BigInteger get_denominator() const;
+
+	// same formats as Fraction (a/b or a), the numbers can have any number of digits
+	friend std::istream& operator>>(std::istream& input, Rational& value);
+	friend std::ostream& operator<<(std::ostream& output, const Rational& value);
+
+private:
+	struct BigValue {
+		BigInteger numerator;
+		BigInteger denominator;
+	};
+	using WideInt = CheckedArithmetic::WideInt;
+
+	// stores numerator / denominator if it fits into the small representation (reduced by the gcd only if it does not fit as it is)
+	bool set_small(WideInt numerator, WideInt denominator);
+	// normalized value, small if it fits
+	static Rational from_big(BigInteger numerator, BigInteger denominator);
+	BigInteger big_numerator() const { return _big ? _big->numerator : BigInteger(_numerator); }
+	BigInteger big_denominator() const { return _big ? _big->denominator : BigInteger(_denominator); }
+
+	// valid when _big is null, the denominator is positive
+	long long _numerator;
+	long long _denominator;
+	// big values are immutable, so copies of a Rational share them
+	std::shared_ptr<const BigValue> _big;
+};
@@ -0,0 +1,625 @@
+// simd_kernels.h
+// Level 1 kernels used in the inner loops of LinSolver algorithms:
+// axpy:       y = y + alpha * x
+// dot:        x[0] * y[0] + ... + x[n-1] * y[n-1] (without complex conjugation, same as LinSolver::dot_product)
+// row_update: y = a * x + b * y (the row operation of Gaussian elimination)
+// All vectors are contiguous arrays of n elements
+// lane_axpy:  y[k * simd_lanes + l] = y[k * simd_lanes + l] + alpha[l] * x[k * simd_lanes + l] for k < n, l < simd_lanes,
+//             the row operation of simd_lanes interleaved systems, each with its own multiplier (BatchedSolver.h)
+// sparse_dot: values[0] * x[indices[0]] + ... + values[n-1] * x[indices[n-1]], one row of a sparse matrix-vector product (SparseMatrix.h)
+//
+// SplitComplexKernels are axpy and dot of complex vectors stored as two arrays, real parts and imaginary parts (SplitComplexMatrix.h)
+//
+// VectorKernels<T> is the compile-time trait selecting the implementation for the element type
+// The primary template is the scalar code written only with the operators required by Numerical
+// double, float and std::complex<double> have explicitly vectorized AVX2 / AVX-512 versions, the best one supported by the running CPU is chosen at runtime
+// Defining LINSOLVE_NO_SIMD disables the vectorized versions
+
+#pragma once
+#include<complex>
+
+#if !defined(LINSOLVE_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define LINSOLVE_X86_SIMD
+#include<immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include<intrin.h>
+// MSVC allows using the intrinsics of any instruction set without target attributes
+#define LINSOLVE_TARGET_AVX2
+#define LINSOLVE_TARGET_AVX512
+#else
+#define LINSOLVE_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LINSOLVE_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma")))
+#endif
+#endif
+
+// number of interleaved vectors processed by lane_axpy, 8 doubles fill one AVX-512 register
+inline constexpr int simd_lanes = 8;
+
+template<typename T>
+struct VectorKernels {
+	static constexpr bool vectorized = false;
+
+	static void axpy(int n, T alpha, const T* x, T* y) {
+		for (int i = 0; i < n; i++)
+			y[i] = y[i] + alpha * x[i];
+	}
+	static T dot(int n, const T* x, const T* y) {
+		T dot = 0;
+		for (int i = 0; i < n; i++)
+			dot = dot + x[i] * y[i];
+		return dot;
+	}
+	static void row_update(int n, T a, const T* x, T b, T* y) {
+		for (int i = 0; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+	static void lane_axpy(int n, const T* alpha, const T* x, T* y) {
+		for (int k = 0; k < n; k++)
+			for (int l = 0; l < simd_lanes; l++)
+				y[k * simd_lanes + l] = y[k * simd_lanes + l] + alpha[l] * x[k * simd_lanes + l];
+	}
+	static T sparse_dot(int n, const T* values, const int* indices, const T* x) {
+		T dot = 0;
+		for (int i = 0; i < n; i++)
+			dot = dot + values[i] * x[indices[i]];
+		return dot;
+	}
+};
+
+// Instruction sets the kernels can be dispatched to
+enum class SimdLevel { Scalar, AVX2, AVX512 };
+
+// Detects the best instruction set supported by both the CPU and the operating system (checked only once)
+inline SimdLevel detect_simd_level()
+{
+#ifdef LINSOLVE_X86_SIMD
+	static const SimdLevel level = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return SimdLevel::Scalar;
+		__cpuid(info, 1);
+		bool fma = (info[2] & (1 << 12)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (!osxsave)
+			return SimdLevel::Scalar;
+		unsigned long long xcr0 = _xgetbv(0);
+		__cpuidex(info, 7, 0);
+		bool avx2 = fma && (info[1] & (1 << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+		bool avx512 = avx2 && (info[1] & (1 << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+#else
+		__builtin_cpu_init();
+		bool avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+		bool avx512 = avx2 && __builtin_cpu_supports("avx512f");
+#endif
+		return avx512 ? SimdLevel::AVX512 : avx2 ? SimdLevel::AVX2 : SimdLevel::Scalar;
+	}();
+	return level;
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+#ifdef LINSOLVE_X86_SIMD
+namespace simd_detail {
+
+	// GCC implements _mm512_reduce_add_pd, _mm512_castpd512_pd256, _mm512_permute_pd and _mm512_movedup_pd with an undefined register
+	// as the merge source, which -Wall reports as uninitialized; the zero-masking forms with all lanes selected do the same without it
+	LINSOLVE_TARGET_AVX512 inline double reduce_add_avx512(__m512d v) {
+		__m256d sum4 = _mm256_add_pd(_mm512_maskz_extractf64x4_pd(0xF, v, 0), _mm512_maskz_extractf64x4_pd(0xF, v, 1));
+		__m128d sum2 = _mm_add_pd(_mm256_castpd256_pd128(sum4), _mm256_extractf128_pd(sum4, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(sum2, _mm_unpackhi_pd(sum2, sum2)));
+	}
+
+	// ==== double ====
+
+	LINSOLVE_TARGET_AVX2 inline void axpy_avx2(int n, double alpha, const double* x, double* y) {
+		__m256d a = _mm256_set1_pd(alpha);
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			_mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+			_mm256_storeu_pd(y + i + 4, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4)));
+		}
+		for (; i + 4 <= n; i += 4)
+			_mm256_storeu_pd(y + i, _mm256_fmadd_pd(a, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i)));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX2 inline double dot_avx2(int n, const double* x, const double* y) {
+		__m256d acc0 = _mm256_setzero_pd();
+		__m256d acc1 = _mm256_setzero_pd();
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+			acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i + 4), _mm256_loadu_pd(y + i + 4), acc1);
+		}
+		for (; i + 4 <= n; i += 4)
+			acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i), acc0);
+		acc0 = _mm256_add_pd(acc0, acc1);
+		__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+		double dot = _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX2 inline void row_update_avx2(int n, double a, const double* x, double b, double* y) {
+		__m256d va = _mm256_set1_pd(a);
+		__m256d vb = _mm256_set1_pd(b);
+		int i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm256_storeu_pd(y + i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x + i), _mm256_mul_pd(vb, _mm256_loadu_pd(y + i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	LINSOLVE_TARGET_AVX2 inline void lane_axpy_avx2(int n, const double* alpha, const double* x, double* y) {
+		__m256d a0 = _mm256_loadu_pd(alpha);
+		__m256d a1 = _mm256_loadu_pd(alpha + 4);
+		for (int k = 0; k < n; k++, x += 8, y += 8) {
+			_mm256_storeu_pd(y, _mm256_fmadd_pd(a0, _mm256_loadu_pd(x), _mm256_loadu_pd(y)));
+			_mm256_storeu_pd(y + 4, _mm256_fmadd_pd(a1, _mm256_loadu_pd(x + 4), _mm256_loadu_pd(y + 4)));
+		}
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void axpy_avx512(int n, double alpha, const double* x, double* y) {
+		__m512d a = _mm512_set1_pd(alpha);
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			_mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+			_mm512_storeu_pd(y + i + 8, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8)));
+		}
+		for (; i + 8 <= n; i += 8)
+			_mm512_storeu_pd(y + i, _mm512_fmadd_pd(a, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i)));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline double dot_avx512(int n, const double* x, const double* y) {
+		__m512d acc0 = _mm512_setzero_pd();
+		__m512d acc1 = _mm512_setzero_pd();
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+			acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i + 8), _mm512_loadu_pd(y + i + 8), acc1);
+		}
+		for (; i + 8 <= n; i += 8)
+			acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i), acc0);
+		double dot = reduce_add_avx512(_mm512_add_pd(acc0, acc1));
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void row_update_avx512(int n, double a, const double* x, double b, double* y) {
+		__m512d va = _mm512_set1_pd(a);
+		__m512d vb = _mm512_set1_pd(b);
+		int i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm512_storeu_pd(y + i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x + i), _mm512_mul_pd(vb, _mm512_loadu_pd(y + i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void lane_axpy_avx512(int n, const double* alpha, const double* x, double* y) {
+		__m512d a = _mm512_loadu_pd(alpha);
+		for (int k = 0; k < n; k++, x += 8, y += 8)
+			_mm512_storeu_pd(y, _mm512_fmadd_pd(a, _mm512_loadu_pd(x), _mm512_loadu_pd(y)));
+	}
+
+	// ==== float ====
+	// same kernels as for double with twice as many elements per register, products are accumulated in float
+
+	LINSOLVE_TARGET_AVX2 inline void axpy_avx2(int n, float alpha, const float* x, float* y) {
+		__m256 a = _mm256_set1_ps(alpha);
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			_mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+			_mm256_storeu_ps(y + i + 8, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8)));
+		}
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_ps(y + i, _mm256_fmadd_ps(a, _mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i)));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX2 inline float dot_avx2(int n, const float* x, const float* y) {
+		__m256 acc0 = _mm256_setzero_ps();
+		__m256 acc1 = _mm256_setzero_ps();
+		int i = 0;
+		for (; i + 16 <= n; i += 16) {
+			acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+			acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i + 8), _mm256_loadu_ps(y + i + 8), acc1);
+		}
+		for (; i + 8 <= n; i += 8)
+			acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(x + i), _mm256_loadu_ps(y + i), acc0);
+		acc0 = _mm256_add_ps(acc0, acc1);
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		float dot = _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX2 inline void row_update_avx2(int n, float a, const float* x, float b, float* y) {
+		__m256 va = _mm256_set1_ps(a);
+		__m256 vb = _mm256_set1_ps(b);
+		int i = 0;
+		for (; i + 8 <= n; i += 8)
+			_mm256_storeu_ps(y + i, _mm256_fmadd_ps(va, _mm256_loadu_ps(x + i), _mm256_mul_ps(vb, _mm256_loadu_ps(y + i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	// 8 float lanes fill one AVX2 register, the AVX-512 version is the same
+	LINSOLVE_TARGET_AVX2 inline void lane_axpy_avx2(int n, const float* alpha, const float* x, float* y) {
+		__m256 a = _mm256_loadu_ps(alpha);
+		for (int k = 0; k < n; k++, x += 8, y += 8)
+			_mm256_storeu_ps(y, _mm256_fmadd_ps(a, _mm256_loadu_ps(x), _mm256_loadu_ps(y)));
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void axpy_avx512(int n, float alpha, const float* x, float* y) {
+		__m512 a = _mm512_set1_ps(alpha);
+		int i = 0;
+		for (; i + 32 <= n; i += 32) {
+			_mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+			_mm512_storeu_ps(y + i + 16, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16)));
+		}
+		for (; i + 16 <= n; i += 16)
+			_mm512_storeu_ps(y + i, _mm512_fmadd_ps(a, _mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i)));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline float dot_avx512(int n, const float* x, const float* y) {
+		__m512 acc0 = _mm512_setzero_ps();
+		__m512 acc1 = _mm512_setzero_ps();
+		int i = 0;
+		for (; i + 32 <= n; i += 32) {
+			acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+			acc1 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i + 16), _mm512_loadu_ps(y + i + 16), acc1);
+		}
+		for (; i + 16 <= n; i += 16)
+			acc0 = _mm512_fmadd_ps(_mm512_loadu_ps(x + i), _mm512_loadu_ps(y + i), acc0);
+		// halves extracted as doubles, _mm512_reduce_add_ps has the same undefined register as _mm512_reduce_add_pd
+		__m512d acc = _mm512_castps_pd(_mm512_add_ps(acc0, acc1));
+		__m256 sum8 = _mm256_add_ps(_mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, acc, 0)), _mm256_castpd_ps(_mm512_maskz_extractf64x4_pd(0xF, acc, 1)));
+		__m128 sum = _mm_add_ps(_mm256_castps256_ps128(sum8), _mm256_extractf128_ps(sum8, 1));
+		sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+		float dot = _mm_cvtss_f32(_mm_add_ss(sum, _mm_movehdup_ps(sum)));
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void row_update_avx512(int n, float a, const float* x, float b, float* y) {
+		__m512 va = _mm512_set1_ps(a);
+		__m512 vb = _mm512_set1_ps(b);
+		int i = 0;
+		for (; i + 16 <= n; i += 16)
+			_mm512_storeu_ps(y + i, _mm512_fmadd_ps(va, _mm512_loadu_ps(x + i), _mm512_mul_ps(vb, _mm512_loadu_ps(y + i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void lane_axpy_avx512(int n, const float* alpha, const float* x, float* y) {
+		lane_axpy_avx2(n, alpha, x, y);
+	}
+
+	// ==== std::complex<double> ====
+	// complex arrays are processed as interleaved (re, im) pairs of doubles, two complex numbers per AVX2 register
+	// the product alpha * x is computed as fmaddsub(re(alpha), x, im(alpha) * swap(x)), where swap exchanges re and im of every element
+
+	LINSOLVE_TARGET_AVX2 inline __m256d complex_mul_avx2(__m256d alpha_re, __m256d alpha_im, __m256d x) {
+		return _mm256_fmaddsub_pd(alpha_re, x, _mm256_mul_pd(alpha_im, _mm256_permute_pd(x, 0x5)));
+	}
+
+	LINSOLVE_TARGET_AVX2 inline void axpy_avx2(int n, std::complex<double> alpha, const std::complex<double>* x, std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m256d a_re = _mm256_set1_pd(alpha.real());
+		__m256d a_im = _mm256_set1_pd(alpha.imag());
+		int i = 0;
+		for (; i + 2 <= n; i += 2)
+			_mm256_storeu_pd(yd + 2 * i, _mm256_add_pd(_mm256_loadu_pd(yd + 2 * i), complex_mul_avx2(a_re, a_im, _mm256_loadu_pd(xd + 2 * i))));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX2 inline std::complex<double> dot_avx2(int n, const std::complex<double>* x, const std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		const double* yd = reinterpret_cast<const double*>(y);
+		__m256d acc = _mm256_setzero_pd();
+		int i = 0;
+		for (; i + 2 <= n; i += 2) {
+			__m256d vx = _mm256_loadu_pd(xd + 2 * i);
+			__m256d vy = _mm256_loadu_pd(yd + 2 * i);
+			__m256d y_re = _mm256_movedup_pd(vy);
+			__m256d y_im = _mm256_permute_pd(vy, 0xF);
+			acc = _mm256_add_pd(acc, _mm256_fmaddsub_pd(vx, y_re, _mm256_mul_pd(_mm256_permute_pd(vx, 0x5), y_im)));
+		}
+		__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(acc), _mm256_extractf128_pd(acc, 1));
+		double parts[2];
+		_mm_storeu_pd(parts, sum);
+		std::complex<double> dot(parts[0], parts[1]);
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX2 inline void row_update_avx2(int n, std::complex<double> a, const std::complex<double>* x, std::complex<double> b, std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m256d a_re = _mm256_set1_pd(a.real()), a_im = _mm256_set1_pd(a.imag());
+		__m256d b_re = _mm256_set1_pd(b.real()), b_im = _mm256_set1_pd(b.imag());
+		int i = 0;
+		for (; i + 2 <= n; i += 2)
+			_mm256_storeu_pd(yd + 2 * i, _mm256_add_pd(complex_mul_avx2(a_re, a_im, _mm256_loadu_pd(xd + 2 * i)), complex_mul_avx2(b_re, b_im, _mm256_loadu_pd(yd + 2 * i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	// the 8 multipliers are split into (re, re) and (im, im) pairs, two lanes per register
+	LINSOLVE_TARGET_AVX2 inline void lane_axpy_avx2(int n, const std::complex<double>* alpha, const std::complex<double>* x, std::complex<double>* y) {
+		const double* ad = reinterpret_cast<const double*>(alpha);
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m256d a_re[4], a_im[4];
+		for (int r = 0; r < 4; r++) {
+			__m256d a = _mm256_loadu_pd(ad + 4 * r);
+			a_re[r] = _mm256_movedup_pd(a);
+			a_im[r] = _mm256_permute_pd(a, 0xF);
+		}
+		for (int k = 0; k < n; k++, xd += 16, yd += 16)
+			for (int r = 0; r < 4; r++)
+				_mm256_storeu_pd(yd + 4 * r, _mm256_add_pd(_mm256_loadu_pd(yd + 4 * r), complex_mul_avx2(a_re[r], a_im[r], _mm256_loadu_pd(xd + 4 * r))));
+	}
+
+	LINSOLVE_TARGET_AVX512 inline __m512d complex_mul_avx512(__m512d alpha_re, __m512d alpha_im, __m512d x) {
+		return _mm512_fmaddsub_pd(alpha_re, x, _mm512_mul_pd(alpha_im, _mm512_maskz_permute_pd(0xFF, x, 0x55)));
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void axpy_avx512(int n, std::complex<double> alpha, const std::complex<double>* x, std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m512d a_re = _mm512_set1_pd(alpha.real());
+		__m512d a_im = _mm512_set1_pd(alpha.imag());
+		int i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm512_storeu_pd(yd + 2 * i, _mm512_add_pd(_mm512_loadu_pd(yd + 2 * i), complex_mul_avx512(a_re, a_im, _mm512_loadu_pd(xd + 2 * i))));
+		for (; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline std::complex<double> dot_avx512(int n, const std::complex<double>* x, const std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		const double* yd = reinterpret_cast<const double*>(y);
+		__m512d acc = _mm512_setzero_pd();
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m512d vx = _mm512_loadu_pd(xd + 2 * i);
+			__m512d vy = _mm512_loadu_pd(yd + 2 * i);
+			__m512d y_re = _mm512_maskz_movedup_pd(0xFF, vy);
+			__m512d y_im = _mm512_maskz_permute_pd(0xFF, vy, 0xFF);
+			acc = _mm512_add_pd(acc, _mm512_fmaddsub_pd(vx, y_re, _mm512_mul_pd(_mm512_maskz_permute_pd(0xFF, vx, 0x55), y_im)));
+		}
+		// even lanes hold real parts, odd lanes imaginary parts
+		std::complex<double> dot(reduce_add_avx512(_mm512_maskz_mov_pd(0x55, acc)), reduce_add_avx512(_mm512_maskz_mov_pd(0xAA, acc)));
+		for (; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void row_update_avx512(int n, std::complex<double> a, const std::complex<double>* x, std::complex<double> b, std::complex<double>* y) {
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m512d a_re = _mm512_set1_pd(a.real()), a_im = _mm512_set1_pd(a.imag());
+		__m512d b_re = _mm512_set1_pd(b.real()), b_im = _mm512_set1_pd(b.imag());
+		int i = 0;
+		for (; i + 4 <= n; i += 4)
+			_mm512_storeu_pd(yd + 2 * i, _mm512_add_pd(complex_mul_avx512(a_re, a_im, _mm512_loadu_pd(xd + 2 * i)), complex_mul_avx512(b_re, b_im, _mm512_loadu_pd(yd + 2 * i))));
+		for (; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void lane_axpy_avx512(int n, const std::complex<double>* alpha, const std::complex<double>* x, std::complex<double>* y) {
+		const double* ad = reinterpret_cast<const double*>(alpha);
+		const double* xd = reinterpret_cast<const double*>(x);
+		double* yd = reinterpret_cast<double*>(y);
+		__m512d a0 = _mm512_loadu_pd(ad), a1 = _mm512_loadu_pd(ad + 8);
+		__m512d a0_re = _mm512_maskz_movedup_pd(0xFF, a0), a0_im = _mm512_maskz_permute_pd(0xFF, a0, 0xFF);
+		__m512d a1_re = _mm512_maskz_movedup_pd(0xFF, a1), a1_im = _mm512_maskz_permute_pd(0xFF, a1, 0xFF);
+		for (int k = 0; k < n; k++, xd += 16, yd += 16) {
+			_mm512_storeu_pd(yd, _mm512_add_pd(_mm512_loadu_pd(yd), complex_mul_avx512(a0_re, a0_im, _mm512_loadu_pd(xd))));
+			_mm512_storeu_pd(yd + 8, _mm512_add_pd(_mm512_loadu_pd(yd + 8), complex_mul_avx512(a1_re, a1_im, _mm512_loadu_pd(xd + 8))));
+		}
+	}
+}
+#endif
+
+// Vectorized kernels for double, float and std::complex<double>, falling back to the scalar loops when the CPU supports neither AVX2 nor AVX-512
+template<typename T>
+struct DispatchedVectorKernels {
+	static constexpr bool vectorized = true;
+
+	static void axpy(int n, T alpha, const T* x, T* y) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::axpy_avx512(n, alpha, x, y); return;
+		case SimdLevel::AVX2: simd_detail::axpy_avx2(n, alpha, x, y); return;
+		default: break;
+		}
+#endif
+		for (int i = 0; i < n; i++)
+			y[i] += alpha * x[i];
+	}
+	static T dot(int n, const T* x, const T* y) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: return simd_detail::dot_avx512(n, x, y);
+		case SimdLevel::AVX2: return simd_detail::dot_avx2(n, x, y);
+		default: break;
+		}
+#endif
+		T dot = 0;
+		for (int i = 0; i < n; i++)
+			dot += x[i] * y[i];
+		return dot;
+	}
+	static void row_update(int n, T a, const T* x, T b, T* y) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::row_update_avx512(n, a, x, b, y); return;
+		case SimdLevel::AVX2: simd_detail::row_update_avx2(n, a, x, b, y); return;
+		default: break;
+		}
+#endif
+		for (int i = 0; i < n; i++)
+			y[i] = a * x[i] + b * y[i];
+	}
+	static void lane_axpy(int n, const T* alpha, const T* x, T* y) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::lane_axpy_avx512(n, alpha, x, y); return;
+		case SimdLevel::AVX2: simd_detail::lane_axpy_avx2(n, alpha, x, y); return;
+		default: break;
+		}
+#endif
+		for (int k = 0; k < n; k++)
+			for (int l = 0; l < simd_lanes; l++)
+				y[k * simd_lanes + l] += alpha[l] * x[k * simd_lanes + l];
+	}
+	// the gathers of scattered x elements are not vectorized, rows of sparse matrices are too short for it to pay off
+	static T sparse_dot(int n, const T* values, const int* indices, const T* x) {
+		T dot = 0;
+		for (int i = 0; i < n; i++)
+			dot += values[i] * x[indices[i]];
+		return dot;
+	}
+};
+
+template<>
+struct VectorKernels<double> : DispatchedVectorKernels<double> {};
+
+template<>
+struct VectorKernels<float> : DispatchedVectorKernels<float> {};
+
+template<>
+struct VectorKernels<std::complex<double>> : DispatchedVectorKernels<std::complex<double>> {};
+
+#ifdef LINSOLVE_X86_SIMD
+namespace simd_detail {
+
+	// ==== split complex ====
+	// (y_re + i * y_im) += (a_re + i * a_im) * (x_re + i * x_im) is y_re += a_re * x_re - a_im * x_im, y_im += a_re * x_im + a_im * x_re
+
+	LINSOLVE_TARGET_AVX2 inline void split_axpy_avx2(int n, double a_re, double a_im, const double* x_re, const double* x_im, double* y_re, double* y_im) {
+		__m256d ar = _mm256_set1_pd(a_re), ai = _mm256_set1_pd(a_im);
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m256d xr = _mm256_loadu_pd(x_re + i), xi = _mm256_loadu_pd(x_im + i);
+			_mm256_storeu_pd(y_re + i, _mm256_fnmadd_pd(ai, xi, _mm256_fmadd_pd(ar, xr, _mm256_loadu_pd(y_re + i))));
+			_mm256_storeu_pd(y_im + i, _mm256_fmadd_pd(ai, xr, _mm256_fmadd_pd(ar, xi, _mm256_loadu_pd(y_im + i))));
+		}
+		for (; i < n; i++) {
+			double xr = x_re[i], xi = x_im[i];
+			y_re[i] += a_re * xr - a_im * xi;
+			y_im[i] += a_re * xi + a_im * xr;
+		}
+	}
+
+	LINSOLVE_TARGET_AVX2 inline double horizontal_sum_avx2(__m256d value) {
+		__m128d sum = _mm_add_pd(_mm256_castpd256_pd128(value), _mm256_extractf128_pd(value, 1));
+		return _mm_cvtsd_f64(_mm_add_sd(sum, _mm_unpackhi_pd(sum, sum)));
+	}
+
+	LINSOLVE_TARGET_AVX2 inline std::complex<double> split_dot_avx2(int n, const double* x_re, const double* x_im, const double* y_re, const double* y_im) {
+		// real part as (x_re * y_re) - (x_im * y_im) in two accumulators, imaginary part in one
+		__m256d rr = _mm256_setzero_pd(), ii = _mm256_setzero_pd(), im = _mm256_setzero_pd();
+		int i = 0;
+		for (; i + 4 <= n; i += 4) {
+			__m256d xr = _mm256_loadu_pd(x_re + i), xi = _mm256_loadu_pd(x_im + i);
+			__m256d yr = _mm256_loadu_pd(y_re + i), yi = _mm256_loadu_pd(y_im + i);
+			rr = _mm256_fmadd_pd(xr, yr, rr);
+			ii = _mm256_fmadd_pd(xi, yi, ii);
+			im = _mm256_fmadd_pd(xi, yr, _mm256_fmadd_pd(xr, yi, im));
+		}
+		double re_sum = horizontal_sum_avx2(_mm256_sub_pd(rr, ii)), im_sum = horizontal_sum_avx2(im);
+		for (; i < n; i++) {
+			re_sum += x_re[i] * y_re[i] - x_im[i] * y_im[i];
+			im_sum += x_re[i] * y_im[i] + x_im[i] * y_re[i];
+		}
+		return { re_sum, im_sum };
+	}
+
+	LINSOLVE_TARGET_AVX512 inline void split_axpy_avx512(int n, double a_re, double a_im, const double* x_re, const double* x_im, double* y_re, double* y_im) {
+		__m512d ar = _mm512_set1_pd(a_re), ai = _mm512_set1_pd(a_im);
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m512d xr = _mm512_loadu_pd(x_re + i), xi = _mm512_loadu_pd(x_im + i);
+			_mm512_storeu_pd(y_re + i, _mm512_fnmadd_pd(ai, xi, _mm512_fmadd_pd(ar, xr, _mm512_loadu_pd(y_re + i))));
+			_mm512_storeu_pd(y_im + i, _mm512_fmadd_pd(ai, xr, _mm512_fmadd_pd(ar, xi, _mm512_loadu_pd(y_im + i))));
+		}
+		for (; i < n; i++) {
+			double xr = x_re[i], xi = x_im[i];
+			y_re[i] += a_re * xr - a_im * xi;
+			y_im[i] += a_re * xi + a_im * xr;
+		}
+	}
+
+	LINSOLVE_TARGET_AVX512 inline std::complex<double> split_dot_avx512(int n, const double* x_re, const double* x_im, const double* y_re, const double* y_im) {
+		__m512d rr = _mm512_setzero_pd(), ii = _mm512_setzero_pd(), im = _mm512_setzero_pd();
+		int i = 0;
+		for (; i + 8 <= n; i += 8) {
+			__m512d xr = _mm512_loadu_pd(x_re + i), xi = _mm512_loadu_pd(x_im + i);
+			__m512d yr = _mm512_loadu_pd(y_re + i), yi = _mm512_loadu_pd(y_im + i);
+			rr = _mm512_fmadd_pd(xr, yr, rr);
+			ii = _mm512_fmadd_pd(xi, yi, ii);
+			im = _mm512_fmadd_pd(xi, yr, _mm512_fmadd_pd(xr, yi, im));
+		}
+		double re_sum = reduce_add_avx512(_mm512_sub_pd(rr, ii)), im_sum = reduce_add_avx512(im);
+		for (; i < n; i++) {
+			re_sum += x_re[i] * y_re[i] - x_im[i] * y_im[i];
+			im_sum += x_re[i] * y_im[i] + x_im[i] * y_re[i];
+		}
+		return { re_sum, im_sum };
+	}
+}
+#endif
+
+// Complex vectors as separate real and imaginary arrays: a complex multiply-add is four fused multiply-adds on full registers
+// of real or imaginary parts, without the shuffles interleaved std::complex<double> needs
+struct SplitComplexKernels {
+	static void axpy(int n, std::complex<double> alpha, const double* x_re, const double* x_im, double* y_re, double* y_im) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: simd_detail::split_axpy_avx512(n, alpha.real(), alpha.imag(), x_re, x_im, y_re, y_im); return;
+		case SimdLevel::AVX2: simd_detail::split_axpy_avx2(n, alpha.real(), alpha.imag(), x_re, x_im, y_re, y_im); return;
+		default: break;
+		}
+#endif
+		for (int i = 0; i < n; i++) {
+			double xr = x_re[i], xi = x_im[i];
+			y_re[i] += alpha.real() * xr - alpha.imag() * xi;
+			y_im[i] += alpha.real() * xi + alpha.imag() * xr;
+		}
+	}
+	static std::complex<double> dot(int n, const double* x_re, const double* x_im, const double* y_re, const double* y_im) {
+#ifdef LINSOLVE_X86_SIMD
+		switch (detect_simd_level()) {
+		case SimdLevel::AVX512: return simd_detail::split_dot_avx512(n, x_re, x_im, y_re, y_im);
+		case SimdLevel::AVX2: return simd_detail::split_dot_avx2(n, x_re, x_im, y_re, y_im);
+		default: break;
+		}
+#endif
+		double re_sum = 0, im_sum = 0;
+		for (int i = 0; i < n; i++) {
+			re_sum += x_re[i] * y_re[i] - x_im[i] * y_im[i];
+			im_sum += x_re[i] * y_im[i] + x_im[i] * y_re[i];
+		}
+		return { re_sum, im_sum };
+	}
+};
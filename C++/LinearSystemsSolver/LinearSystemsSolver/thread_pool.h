@@ -0,0 +1,154 @@
+// thread_pool.h
+// Fixed size pool of worker threads shared by all parallel algorithms of the library
+// Work is submitted as a parallel loop, iterations are handed out one by one to the workers and to the calling thread
+// Loops started from inside a worker run sequentially, so parallel algorithms can call each other without deadlocking
+
+#pragma once
+#include<vector>
+#include<thread>
+#include<mutex>
+#include<condition_variable>
+#include<atomic>
+#include<functional>
+#include<exception>
+
+class ThreadPool {
+public:
+	explicit ThreadPool(int thread_count = default_thread_count()) {
+		for (int i = 1; i < thread_count; i++)
+			_workers.emplace_back([this] { worker_loop(); });
+	}
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_stopping = true;
+		}
+		_job_ready.notify_all();
+		for (auto&& worker : _workers)
+			worker.join();
+	}
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// pool used by the library, created on first use with one thread per hardware core
+	static ThreadPool& instance() {
+		static ThreadPool pool;
+		return pool;
+	}
+	static int default_thread_count() {
+		unsigned int count = std::thread::hardware_concurrency();
+		return count == 0 ? 1 : static_cast<int>(count);
+	}
+
+	// number of threads working on a loop, including the calling thread
+	int get_thread_count() const { return static_cast<int>(_workers.size()) + 1; }
+
+	// calls body(i) for every i in [begin, end)
+	// the first exception thrown by body is rethrown in the calling thread after all the running iterations finish
+	template<typename Body>
+	void parallel_for(int begin, int end, const Body& body);
+
+private:
+	struct Job {
+		std::function<void(int)> body;
+		std::atomic<int> next;
+		int end;
+		std::atomic<bool> failed;
+		std::exception_ptr error;
+		std::mutex error_mutex;
+	};
+
+	void worker_loop();
+	static void run_job(Job& job);
+
+	std::vector<std::thread> _workers;
+	std::mutex _submit_mutex;
+	std::mutex _mutex;
+	std::condition_variable _job_ready;
+	std::condition_variable _job_done;
+	Job* _job = nullptr;
+	size_t _generation = 0;
+	int _pending_workers = 0;
+	bool _stopping = false;
+
+	static inline thread_local bool _inside_pool = false;
+};
+
+template<typename Body>
+void ThreadPool::parallel_for(int begin, int end, const Body& body)
+{
+	if (end <= begin)
+		return;
+	if (_workers.empty() || _inside_pool || end - begin == 1) {
+		for (int i = begin; i < end; i++)
+			body(i);
+		return;
+	}
+
+	std::lock_guard<std::mutex> submit_lock(_submit_mutex);
+	Job job;
+	job.body = [&body](int i) { body(i); };
+	job.next = begin;
+	job.end = end;
+	job.failed = false;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_job = &job;
+		_generation++;
+		_pending_workers = static_cast<int>(_workers.size());
+	}
+	_job_ready.notify_all();
+
+	_inside_pool = true;
+	run_job(job);
+	_inside_pool = false;
+
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_job_done.wait(lock, [this] { return _pending_workers == 0; });
+		_job = nullptr;
+	}
+	if (job.error)
+		std::rethrow_exception(job.error);
+}
+
+inline void ThreadPool::worker_loop()
+{
+	_inside_pool = true;
+	size_t seen_generation = 0;
+	while (true) {
+		Job* job;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_job_ready.wait(lock, [&] { return _stopping || _generation != seen_generation; });
+			if (_stopping)
+				return;
+			seen_generation = _generation;
+			job = _job;
+		}
+		run_job(*job);
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_pending_workers--;
+		}
+		_job_done.notify_one();
+	}
+}
+
+inline void ThreadPool::run_job(Job& job)
+{
+	while (!job.failed) {
+		int i = job.next++;
+		if (i >= job.end)
+			return;
+		try {
+			job.body(i);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(job.error_mutex);
+			if (!job.error)
+				job.error = std::current_exception();
+			job.failed = true;
+		}
+	}
+}